@@ -30,22 +30,37 @@ extern "C" { // TODO: file upstream bug
 }
 
 #include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <deque>
 #include <expected>
 #include <format>
+#include <fstream>
 #include <functional>
 #include <iostream>
+#include <latch>
 #include <map>
+#include <memory>
+#include <optional>
+#include <random>
 #include <ranges>
 #include <set>
 #include <span>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
 #include <cassert>
+#include <cctype>
 #include <cerrno>
 #include <cinttypes>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <poll.h>
 #include <unistd.h>
 
 #include "defs.hh"
@@ -59,19 +74,83 @@ using namespace std::literals;
 
 namespace netd {
 
-auto netd_connect() noexcept -> int;
+auto netd_connect() noexcept -> std::expected<int, std::error_code>;
 
-using cmdhandler =
-	std::function<int(int server, std::span<std::string_view const> args)>;
+/*
+ * a connection to netd.  this is only established when a command first needs
+ * to talk to the server, so commands which don't (such as reading the stats
+ * segment) work even if netd isn't running.
+ */
+struct connection final {
+	connection() noexcept = default;
+	connection(connection const &) = delete;
+	connection(connection &&) = delete;
+	auto operator=(connection const &) -> connection & = delete;
+	auto operator=(connection &&) -> connection & = delete;
+
+	~connection()
+	{
+		if (_fd != -1)
+			::close(_fd);
+	}
+
+	[[nodiscard]] auto get() noexcept -> std::expected<int, std::error_code>
+	{
+		if (_fd == -1) {
+			auto fd = netd_connect();
+			if (!fd)
+				return std::unexpected(fd.error());
+			_fd = *fd;
+		}
+
+		return _fd;
+	}
+
+private:
+	int _fd = -1;
+};
+
+using cmdhandler = std::function<int(connection			     &server,
+				     std::span<std::string_view const> args)>;
 
-auto c_intf_list(int server, std::span<std::string_view const> args) noexcept
-	-> int;
-auto c_net_list(int server, std::span<std::string_view const> args) noexcept
-	-> int;
-auto c_net_create(int server, std::span<std::string_view const> args) noexcept
-	-> int;
-auto c_net_delete(int server, std::span<std::string_view const> args) noexcept
-	-> int;
+/*
+ * a command which sends a single request and only needs a status back is
+ * given as a function to build the request, which returns a usage message if
+ * the arguments are wrong.  building the request separately from sending it
+ * lets batch mode pipeline these commands.
+ */
+using reqbuilder = std::function<std::expected<nvl, std::string>(
+	std::span<std::string_view const> args)>;
+
+auto run_request(connection &server, std::span<std::string_view const> args,
+		 reqbuilder const &build) noexcept -> int;
+
+auto c_intf_list(connection			   &server,
+		 std::span<std::string_view const> args) noexcept -> int;
+auto c_intf_memory(connection			    &server,
+		   std::span<std::string_view const> args) noexcept -> int;
+auto c_net_list(connection			  &server,
+		std::span<std::string_view const> args) noexcept -> int;
+auto r_net_create(std::span<std::string_view const> args)
+	-> std::expected<nvl, std::string>;
+auto r_net_delete(std::span<std::string_view const> args)
+	-> std::expected<nvl, std::string>;
+auto r_net_txn(std::span<std::string_view const> args)
+	-> std::expected<nvl, std::string>;
+auto c_addr_lookup(connection			    &server,
+		   std::span<std::string_view const> args) noexcept -> int;
+auto c_route_lookup(connection			     &server,
+		    std::span<std::string_view const> args) noexcept -> int;
+auto c_route_list(connection			    &server,
+		  std::span<std::string_view const> args) noexcept -> int;
+auto c_route_stats(connection			    &server,
+		   std::span<std::string_view const> args) noexcept -> int;
+auto c_neigh_list(connection			    &server,
+		  std::span<std::string_view const> args) noexcept -> int;
+auto c_daemon_stats(connection			     &server,
+		    std::span<std::string_view const> args) noexcept -> int;
+auto c_bench(connection			      &server,
+	     std::span<std::string_view const> args) noexcept -> int;
 
 struct command {
 	using cmdmap = std::map<std::string_view, command>;
@@ -81,6 +160,16 @@ struct command {
 	{
 	}
 
+	command(std::string_view description, reqbuilder builder) noexcept
+	try : cm_handler([builder](connection			    &server,
+				   std::span<std::string_view const> args) {
+		      return run_request(server, args, builder);
+	      }),
+	      cm_request(std::move(builder)), cm_description(description) {
+	} catch (...) {
+		abort();
+	}
+
 	command(std::string_view description, cmdmap &&subs) noexcept
 	try : cm_subs(std::move(subs)), cm_description(description) {
 	} catch (...) {
@@ -113,38 +202,37 @@ struct command {
 	}
 
 	cmdhandler	 cm_handler;
+	reqbuilder	 cm_request; /* if the command can be pipelined */
 	cmdmap		 cm_subs;
 	std::string_view cm_description;
 };
 
 /*
- * send the given command to the server and return the response.
+ * send a packed command to the server.  flags are passed to sendmsg(2) along
+ * with MSG_EOR.
  */
-auto nv_xfer(int server, nvl const &cmd) noexcept
-	-> std::expected<nvl, std::error_code>
+auto send_msg(int server, std::span<std::byte const> cmdbuf,
+	      int flags = 0) noexcept -> std::expected<void, std::error_code>
 {
-	/* make sure the nvlist is not errored */
-	if (auto error = cmd.error(); error)
-		return std::unexpected(*error);
-
-	/* send the command */
-
-	auto cmdbuf = cmd.pack();
-	if (!cmdbuf)
-		return std::unexpected(cmdbuf.error());
-
-	auto iov = iovec{data(*cmdbuf), size(*cmdbuf)};
+	auto iov = iovec{const_cast<std::byte *>(cmdbuf.data()), cmdbuf.size()};
 
 	msghdr mhdr{};
 	mhdr.msg_iov = &iov;
 	mhdr.msg_iovlen = 1;
 
-	auto n = ::sendmsg(server, &mhdr, MSG_EOR);
+	auto n = ::sendmsg(server, &mhdr, MSG_EOR | flags);
 	if (n == -1)
 		return std::unexpected(std::make_error_code(std::errc(errno)));
 
-	/* read the response */
+	return {};
+}
 
+/*
+ * read one response from the server.
+ */
+auto recv_msg(int server) noexcept
+	-> std::expected<std::vector<std::byte>, std::error_code>
+{
 	auto respbuf = std::vector<std::byte>();
 	try {
 		respbuf.resize(proto::max_msg_size);
@@ -152,14 +240,13 @@ auto nv_xfer(int server, nvl const &cmd) noexcept
 		abort();
 	}
 
-	iov.iov_base = respbuf.data();
-	iov.iov_len = respbuf.size();
+	auto iov = iovec{respbuf.data(), respbuf.size()};
 
-	memset(&mhdr, 0, sizeof(mhdr));
+	msghdr mhdr{};
 	mhdr.msg_iov = &iov;
 	mhdr.msg_iovlen = 1;
 
-	n = ::recvmsg(server, &mhdr, 0);
+	auto n = ::recvmsg(server, &mhdr, 0);
 	if (n == -1)
 		return std::unexpected(error::from_errno());
 
@@ -172,8 +259,46 @@ auto nv_xfer(int server, nvl const &cmd) noexcept
 	if ((mhdr.msg_flags & MSG_EOR) == 0)
 		return std::unexpected(error::from_errno(ENOMSG));
 
+	respbuf.resize(static_cast<std::size_t>(n));
+	return respbuf;
+}
+
+/*
+ * send the given command to the server and return the raw response.
+ */
+auto xfer(connection &conn, nvl const &cmd) noexcept
+	-> std::expected<std::vector<std::byte>, std::error_code>
+{
+	/* make sure the nvlist is not errored */
+	if (auto error = cmd.error(); error)
+		return std::unexpected(*error);
+
+	auto server = conn.get();
+	if (!server)
+		return std::unexpected(server.error());
+
+	auto cmdbuf = cmd.pack();
+	if (!cmdbuf)
+		return std::unexpected(cmdbuf.error());
+
+	if (auto ret = send_msg(*server, *cmdbuf); !ret)
+		return std::unexpected(ret.error());
+
+	return recv_msg(*server);
+}
+
+/*
+ * send the given command to the server and return the response.
+ */
+auto nv_xfer(connection &server, nvl const &cmd) noexcept
+	-> std::expected<nvl, std::error_code>
+{
+	auto respbuf = xfer(server, cmd);
+	if (!respbuf)
+		return std::unexpected(respbuf.error());
+
 	/* unpack and return the response */
-	auto resp = nvl::unpack(respbuf | std::views::take(n));
+	auto resp = nvl::unpack(*respbuf);
 	if (!resp)
 		return std::unexpected(resp.error());
 
@@ -184,7 +309,7 @@ auto nv_xfer(int server, nvl const &cmd) noexcept
  * send a simple command (with no arguments) to the server and return the
  * response.
  */
-auto send_simple_command(int server, std::string_view command) noexcept
+auto send_simple_command(connection &server, std::string_view command) noexcept
 	-> std::expected<nvl, std::error_code>
 {
 	auto cmd = nvl();
@@ -199,6 +324,8 @@ void usage(command const &root) noexcept
 {
 	(void)print(stderr, "usage: {} [--libxo=...] <command>\n",
 		    getprogname());
+	(void)print(stderr, "       {} [--libxo=...] -f <file | ->\n",
+		    getprogname());
 	(void)print(stderr, "\n");
 	(void)print(stderr, "commands:\n");
 	(void)print(stderr, "\n");
@@ -208,98 +335,345 @@ void usage(command const &root) noexcept
 			    cmd.second.cm_description);
 }
 
-auto c_intf_list(int server, std::span<std::string_view const> args) noexcept
-	-> int
+/*
+ * convert protocol interface states to display strings.
+ */
+auto admin_state_name(std::uint64_t state) noexcept -> std::string_view
+{
+	switch (state) {
+	case proto::cv_iface_admin_up:
+		return "UP"sv;
+	case proto::cv_iface_admin_down:
+		return "DOWN"sv;
+	default:
+		return "UNK"sv;
+	}
+}
+
+auto oper_state_name(std::uint64_t state) noexcept -> std::string_view
+{
+	switch (state) {
+	case proto::cv_iface_oper_not_present:
+		return "NOHW"sv;
+	case proto::cv_iface_oper_down:
+		return "DOWN"sv;
+	case proto::cv_iface_oper_lower_down:
+		return "LDWN"sv;
+	case proto::cv_iface_oper_testing:
+		return "TEST"sv;
+	case proto::cv_iface_oper_dormant:
+		return "DRMT"sv;
+	case proto::cv_iface_oper_up:
+		return "UP"sv;
+	default:
+		return "UNK"sv;
+	}
+}
+
+/*
+ * parse an interface state as printed by show_interface(), ignoring case.
+ */
+template<typename Namefn>
+auto parse_state(std::string_view str, std::uint64_t last, Namefn namefn)
+	-> std::optional<std::uint64_t>
+{
+	auto iequal = [](char a, char b) {
+		return std::toupper(static_cast<unsigned char>(a)) == b;
+	};
+
+	for (auto state = std::uint64_t{1}; state <= last; ++state)
+		if (std::ranges::equal(str, namefn(state), iequal))
+			return state;
+
+	return {};
+}
+
+/*
+ * print a single interface in an interface list.
+ */
+auto show_interface(std::string_view name,
+		    std::uint64_t    adminstate,
+		    std::uint64_t    operstate,
+		    std::uint64_t    txrate,
+		    std::uint64_t    rxrate) -> void
+{
+	auto intf_instance = xo::instance("interface");
+	xo::emit("{V:name/%-16s}"
+		 "{V:admin-state/%-6s}"
+		 "{V:oper-state/%-5s}"
+		 "{[:8}{Vhn,hn-decimal,hn-1000:txrate/%ju}b/s{]:}"
+		 "{[:8}{Vhn,hn-decimal,hn-1000:rxrate/%ju}b/s{]:}"
+		 "\n",
+		 name, admin_state_name(adminstate),
+		 oper_state_name(operstate), txrate, rxrate);
+}
+
+/*
+ * warn that netd answered from its warm-start image because it hasn't
+ * finished starting up.
+ */
+auto show_stale() -> void
+{
+	xo::emit("{W:/%s: netd is still starting; "
+		 "this information may be out of date}\n",
+		 getprogname());
+}
+
+auto show_interface_header() -> void
+{
+	xo::emit("{T:NAME/%-16s}{T:ADMIN/%-6s}{T:OPER/%-5s}"
+		 "{T:TX/%8s}{T:RX/%8s}\n");
+}
+
+/*
+ * print an interface list sent in the binary wire format.
+ */
+auto show_intf_list_wire(std::span<std::byte const> resp) noexcept -> int
+{
+	auto intfs = proto::wire::parse<proto::wire::interface>(resp);
+	if (!intfs) {
+		xo::emit("{E:/%s: invalid response: %s}\n", getprogname(),
+			 intfs.error().message());
+		return 1;
+	}
+
+	if (std::ranges::any_of(*intfs, [](auto const &intf) {
+		    return (intf.if_status & proto::wire::if_status_stale) != 0;
+	    }))
+		show_stale();
+
+	if (intfs->empty()) {
+		xo::emit("{E:no interfaces configured}\n");
+		return 0;
+	}
+
+	show_interface_header();
+
+	for (auto &&intf: *intfs)
+		show_interface(intf.name(), intf.if_admin, intf.if_oper,
+			       intf.if_txrate, intf.if_rxrate);
+
+	return 0;
+}
+
+/*
+ * print the interface list from the shared-memory stats segment, without
+ * talking to netd.
+ */
+auto show_intf_list_shm() noexcept -> int
+{
+	auto intfs = std::expected<std::vector<proto::shm::record>,
+				   std::error_code>();
+
+	/* if netd replaced the file while we were reading it, open it again */
+	do {
+		auto segment = proto::shm::reader::open();
+		if (!segment) {
+			xo::emit("{E:/%s: %s: %s}\n", getprogname(),
+				 proto::shm::path, segment.error().message());
+			return 1;
+		}
+
+		intfs = segment->snapshot();
+	} while (!intfs && intfs.error() == std::errc(ESTALE));
+
+	if (!intfs) {
+		xo::emit("{E:/%s: %s: %s}\n", getprogname(), proto::shm::path,
+			 intfs.error().message());
+		return 1;
+	}
+
+	if (intfs->empty()) {
+		xo::emit("{E:no interfaces configured}\n");
+		return 0;
+	}
+
+	show_interface_header();
+
+	for (auto &&intf: *intfs)
+		show_interface(intf.name(), intf.sr_admin, intf.sr_oper,
+			       intf.sr_txrate, intf.sr_rxrate);
+
+	return 0;
+}
+
+auto c_intf_list(connection			   &server,
+		 std::span<std::string_view const> args) noexcept -> int
 {
 	auto xo_guard = xo::xo();
 	auto intf_container = xo::container("interface-list");
 
-	if (!args.empty()) {
-		xo::emit("{E/usage: %s interface list}\n", getprogname());
+	auto usage = [] {
+		xo::emit("{E/usage: %s interface list [--shm] [--name pattern]"
+			 " [--kind kind] [--admin state] [--oper state]}\n",
+			 getprogname());
 		return 1;
+	};
+
+	auto cmd = nvl();
+	cmd.add_string(proto::cp_cmd, proto::cc_getifs);
+
+	/* the filters are evaluated by netd */
+	auto shm = false;
+	for (auto i = std::size_t{0}; i < args.size(); ++i) {
+		auto opt = args[i];
+
+		if (opt == "--shm") {
+			shm = true;
+			continue;
+		}
+
+		if (i + 1 == args.size())
+			return usage();
+
+		auto value = args[++i];
+
+		if (opt == "--name") {
+			cmd.add_string(proto::cp_iface_match_name, value);
+		} else if (opt == "--kind") {
+			cmd.add_string(proto::cp_iface_match_kind, value);
+		} else if (opt == "--admin") {
+			auto state = parse_state(
+				value, proto::cv_iface_admin_up,
+				admin_state_name);
+			if (!state)
+				return usage();
+			cmd.add_number(proto::cp_iface_match_admin, *state);
+		} else if (opt == "--oper") {
+			auto state = parse_state(value, proto::cv_iface_oper_up,
+						 oper_state_name);
+			if (!state)
+				return usage();
+			cmd.add_number(proto::cp_iface_match_oper, *state);
+		} else
+			return usage();
 	}
 
-	auto resp = send_simple_command(server, proto::cc_getifs);
-	if (!resp) {
+	/* the shared-memory segment can't be filtered */
+	if (shm) {
+		if (args.size() != 1)
+			return usage();
+		return show_intf_list_shm();
+	}
+
+	/*
+	 * ask for the binary format; if the server doesn't support it, we'll
+	 * get an nvlist instead.
+	 */
+	cmd.add_number(proto::cp_wire_version, proto::wire::version);
+
+	auto respbuf = xfer(server, cmd);
+	if (!respbuf) {
 		xo::emit("{E:/%s: failed to send command: %s\n}", getprogname(),
+			 respbuf.error().message());
+		return 1;
+	}
+
+	if (proto::wire::is_wire(*respbuf))
+		return show_intf_list_wire(*respbuf);
+
+	auto resp = nvl::unpack(*respbuf);
+	if (!resp) {
+		xo::emit("{E:/%s: invalid response: %s\n}", getprogname(),
 			 resp.error().message());
 		return 1;
 	}
 
-	if (!resp->exists_nvlist_array(proto::cp_iface)) {
+	auto reply = schema::decode(proto::intf_list_reply_schema, *resp);
+	if (!reply) {
+		xo::emit("{E:/%s: invalid response: %s}\n", getprogname(),
+			 reply.error().message());
+		return 1;
+	}
+
+	if (reply->il_stale.value_or(false))
+		show_stale();
+
+	if (reply->il_interfaces.empty()) {
 		/* no interfaces available */
 		xo::emit("{E:no interfaces configured}\n");
 		return 0;
 	}
 
-	xo::emit("{T:NAME/%-16s}{T:ADMIN/%-6s}{T:OPER/%-5s}"
-		 "{T:TX/%8s}{T:RX/%8s}\n");
+	show_interface_header();
 
-	for (auto &&intf: resp->get_nvlist_array(proto::cp_iface)) {
-		auto operstate = "UNK"sv, adminstate = "UNK"sv;
+	for (auto &&intf: reply->il_interfaces)
+		show_interface(
+			intf.if_name,
+			intf.if_admin.value_or(proto::cv_iface_admin_unknown),
+			intf.if_oper.value_or(proto::cv_iface_oper_unknown),
+			intf.if_txrate.value_or(0), intf.if_rxrate.value_or(0));
 
-		if (!intf.exists_string(proto::cp_iface_name)
-		    || !intf.exists_number(proto::cp_iface_admin)
-		    || !intf.exists_number(proto::cp_iface_oper)
-		    || !intf.exists_number(proto::cp_iface_txrate)
-		    || !intf.exists_number(proto::cp_iface_rxrate)) {
-			xo::emit("{E:/%s: invalid response}\n", getprogname());
-			return 1;
-		}
+	return 0;
+}
 
-		switch (intf.get_number(proto::cp_iface_admin)) {
-		case proto::cv_iface_admin_up:
-			adminstate = "UP"sv;
-			break;
+/*
+ * show the memory used by the interface database, by category, as a total and
+ * per interface.
+ */
+auto c_intf_memory(connection			    &server,
+		   std::span<std::string_view const> args) noexcept -> int
+{
+	auto xo_guard = xo::xo();
 
-		case proto::cv_iface_admin_down:
-			adminstate = "DOWN"sv;
-			break;
+	if (!args.empty()) {
+		xo::emit("{E/usage: %s interface memory}\n", getprogname());
+		return 1;
+	}
 
-		default:
-			break;
-		}
+	auto resp = send_simple_command(server, proto::cc_intfmemory);
+	if (!resp) {
+		xo::emit("{E:/%s: failed to send command: %s\n}", getprogname(),
+			 resp.error().message());
+		return 1;
+	}
 
-		switch (intf.get_number(proto::cp_iface_oper)) {
-		case proto::cv_iface_oper_not_present:
-			operstate = "NOHW"sv;
-			break;
-		case proto::cv_iface_oper_down:
-			operstate = "DOWN"sv;
-			break;
-		case proto::cv_iface_oper_lower_down:
-			operstate = "LDWN"sv;
-			break;
-		case proto::cv_iface_oper_testing:
-			operstate = "TEST"sv;
-			break;
-		case proto::cv_iface_oper_dormant:
-			operstate = "DRMT"sv;
-			break;
-		case proto::cv_iface_oper_up:
-			operstate = "UP"sv;
-			break;
-		default:
-			break;
-		}
+	if (is_error(*resp))
+		return 1;
+
+	auto reply = schema::decode(proto::intf_memory_reply_schema, *resp);
+	if (!reply) {
+		xo::emit("{E:/%s: invalid response: %s}\n", getprogname(),
+			 reply.error().message());
+		return 1;
+	}
 
-		auto intf_instance = xo::instance("interface");
-		xo::emit("{V:name/%-16s}"
-			 "{V:admin-state/%-6s}"
-			 "{V:oper-state/%-5s}"
-			 "{[:8}{Vhn,hn-decimal,hn-1000:txrate/%ju}b/s{]:}"
-			 "{[:8}{Vhn,hn-decimal,hn-1000:rxrate/%ju}b/s{]:}"
-			 "\n",
-			 intf.get_string(proto::cp_iface_name), adminstate,
-			 operstate, intf.get_number(proto::cp_iface_txrate),
-			 intf.get_number(proto::cp_iface_rxrate));
+	auto categories = std::array{
+		std::pair{"hot"sv, reply->im_hot_bytes},
+		std::pair{"cold"sv, reply->im_cold_bytes},
+		std::pair{"names"sv, reply->im_name_bytes},
+		std::pair{"addresses"sv, reply->im_addr_bytes},
+		std::pair{"indexes"sv, reply->im_index_bytes},
+		std::pair{"address-index"sv, reply->im_addr_index_bytes},
+		std::pair{"snapshot"sv, reply->im_snapshot_bytes},
+	};
+
+	auto nintfs = reply->im_interfaces;
+	auto per_intf = [&](std::uint64_t bytes) -> std::uint64_t {
+		return nintfs > 0 ? bytes / nintfs : 0;
+	};
+
+	auto memory_container = xo::container("interface-memory");
+	xo::emit("{Lwc:Interfaces}{V:interfaces/%ju}\n\n", nintfs);
+	xo::emit("{T:CATEGORY/%-16s}{T:BYTES/%12s}{T:PER INTERFACE/%16s}\n");
+
+	auto total = std::uint64_t{0};
+	for (auto &&[name, bytes]: categories) {
+		auto category_instance = xo::instance("category");
+		xo::emit("{V:name/%-16s}{V:bytes/%12ju}"
+			 "{V:per-interface/%16ju}\n",
+			 name, bytes, per_intf(bytes));
+		total += bytes;
 	}
 
+	xo::emit("{L:/%-16s}{V:total-bytes/%12ju}"
+		 "{V:total-per-interface/%16ju}\n",
+		 "total", total, per_intf(total));
 	return 0;
 }
 
-auto c_net_list(int server, std::span<std::string_view const> args) noexcept
-	-> int
+auto c_net_list(connection			  &server,
+		std::span<std::string_view const> args) noexcept -> int
 {
 	auto xo_guard = xo::xo();
 	auto net_container = xo::container("network-link");
@@ -316,145 +690,870 @@ auto c_net_list(int server, std::span<std::string_view const> args) noexcept
 		return 1;
 	}
 
-	if (!resp->exists_nvlist_array(proto::cp_nets))
+	auto reply = schema::decode(proto::net_list_reply_schema, *resp);
+	if (!reply) {
+		xo::emit("{E:/%s: invalid response: %s}\n", getprogname(),
+			 reply.error().message());
+		return 1;
+	}
+
+	if (reply->nl_networks.empty())
 		/* no networks configured */
 		return 0;
 
 	xo::emit("{T:NAME/%-16s}\n");
 
-	for (auto &&net: resp->get_nvlist_array(proto::cp_nets)) {
-		if (!net.exists_string(proto::cp_net_name)) {
-			xo::emit("{E:/%s: invalid response}\n", getprogname());
-			return 1;
-		}
-
+	for (auto &&net: reply->nl_networks) {
 		auto net_instance = xo::instance("network");
-		xo::emit("{V:name/%-16s}\n",
-			 net.get_string(proto::cp_net_name));
+		xo::emit("{V:name/%-16s}\n", net.net_name);
 	}
 
 	return 0;
 }
 
-auto c_net_create(int server, std::span<std::string_view const> args) noexcept
-	-> int
+/*
+ * check the status of a response, returning the error message if it failed.
+ */
+auto reply_status(nvl const &resp) -> std::expected<void, std::string>
 {
-	auto xo_guard = xo::xo();
+	if (!resp.exists_string(proto::cp_status))
+		return std::unexpected("invalid response"s);
 
-	if (args.size() != 1) {
-		xo::emit("{E/usage: %s network create <name>}\n",
-			 getprogname());
-		return 1;
-	}
+	if (resp.get_string(proto::cp_status) == proto::cv_status_success)
+		return {};
+
+	/* we got an error */
+	if (!resp.exists_string(proto::cp_status_info))
+		return std::unexpected("invalid response"s);
+
+	auto info = std::string(resp.get_string(proto::cp_status_info));
 
-	nvl cmd;
+	/* a failed TXN says which operation failed; number them from 1 */
+	if (resp.exists_number(proto::cp_txn_failed))
+		return std::unexpected(
+			std::format("{} (operation {})", info,
+				    resp.get_number(proto::cp_txn_failed) + 1));
 
-	cmd.add_string(proto::cp_cmd, proto::cc_newnet);
-	cmd.add_string(proto::cp_newnet_name, args[0]);
+	return std::unexpected(std::move(info));
+}
+
+/*
+ * run a command given as a reqbuilder: build the request, send it and check
+ * the status of the reply.
+ */
+auto run_request(connection &server, std::span<std::string_view const> args,
+		 reqbuilder const &build) noexcept -> int
+try {
+	auto xo_guard = xo::xo();
 
-	if (auto error = cmd.error(); error) {
-		xo::emit("{E:/%s: nvlist: %s\n}", getprogname(),
-			 error->message());
+	auto cmd = build(args);
+	if (!cmd) {
+		xo::emit("{E:/%s}\n", cmd.error());
 		return 1;
 	}
 
-	auto resp = nv_xfer(server, cmd);
-
+	auto resp = nv_xfer(server, *cmd);
 	if (!resp) {
 		xo::emit("{E:/%s: failed to send command: %s\n}", getprogname(),
 			 resp.error().message());
 		return 1;
 	}
 
-	if (!resp->exists_string(proto::cp_status)) {
-		xo::emit("{E:/%s: invalid response}", getprogname());
+	if (auto status = reply_status(*resp); !status) {
+		xo::emit("{E:/%s: %s}\n", getprogname(), status.error());
 		return 1;
 	}
 
-	auto status = resp->get_string(proto::cp_status);
+	return 0;
+} catch (std::bad_alloc const &) {
+	abort();
+}
 
-	if (status == proto::cv_status_success)
-		return 0;
+/*
+ * build a request with a single string argument.
+ */
+auto string_request(cstring_view cmdname, cstring_view key,
+		    std::string_view value) -> std::expected<nvl, std::string>
+{
+	auto cmd = nvl();
 
-	/* we got an error */
-	if (!resp->exists_string(proto::cp_status_info)) {
-		xo::emit("{E:/%s: invalid response}", getprogname());
-		return 1;
+	cmd.add_string(proto::cp_cmd, cmdname);
+	cmd.add_string(key, value);
+
+	if (auto error = cmd.error(); error)
+		return std::unexpected(
+			std::format("nvlist: {}", error->message()));
+
+	return cmd;
+}
+
+auto r_net_create(std::span<std::string_view const> args)
+	-> std::expected<nvl, std::string>
+{
+	if (args.size() != 1)
+		return std::unexpected(std::format(
+			"usage: {} network create <name>", getprogname()));
+
+	return string_request(proto::cc_newnet, proto::cp_newnet_name,
+			      args[0]);
+}
+
+auto r_net_delete(std::span<std::string_view const> args)
+	-> std::expected<nvl, std::string>
+{
+	if (args.size() != 1)
+		return std::unexpected(std::format(
+			"usage: {} network delete <name>", getprogname()));
+
+	return string_request(proto::cc_delnet, proto::cp_delnet_name,
+			      args[0]);
+}
+
+/*
+ * network txn create|delete <name> [create|delete <name>...]: apply the
+ * operations in one TXN, so either all of them happen or none do.
+ */
+auto r_net_txn(std::span<std::string_view const> args)
+	-> std::expected<nvl, std::string>
+{
+	auto usage = std::format(
+		"usage: {} network txn create|delete <name> ...",
+		getprogname());
+
+	if (args.empty() || args.size() % 2 != 0)
+		return std::unexpected(usage);
+
+	if (args.size() / 2 > proto::txn_max_ops)
+		return std::unexpected(
+			std::format("{}: at most {} operations", getprogname(),
+				    proto::txn_max_ops));
+
+	auto request = proto::txn_request();
+
+	for (auto i = std::size_t{0}; i < args.size(); i += 2) {
+		auto op = cstring_view();
+		if (args[i] == "create")
+			op = proto::cc_newnet;
+		else if (args[i] == "delete")
+			op = proto::cc_delnet;
+		else
+			return std::unexpected(usage);
+
+		request.tx_ops.push_back(
+			{.to_op = std::string(op),
+			 .to_name = std::string(args[i + 1])});
 	}
 
-	xo::emit("{E:/%s}\n", resp->get_string(proto::cp_status));
-	return 1;
+	auto cmd = schema::encode(proto::txn_request_schema, request);
+	cmd.add_string(proto::cp_cmd, proto::cc_txn);
+
+	if (auto error = cmd.error(); error)
+		return std::unexpected(
+			std::format("nvlist: {}", error->message()));
+
+	return cmd;
 }
 
-auto c_net_delete(int server, std::span<std::string_view const> args) noexcept
-	-> int
+auto c_addr_lookup(connection			    &server,
+		   std::span<std::string_view const> args) noexcept -> int
 {
 	auto xo_guard = xo::xo();
+	auto addr_container = xo::container("address-list");
 
 	if (args.size() != 1) {
-		xo::emit("{E/usage: %s network delete <name>}\n",
+		xo::emit("{E/usage: %s address lookup <address[/prefixlen]>}\n",
 			 getprogname());
 		return 1;
 	}
 
-	nvl cmd;
-
-	cmd.add_string(proto::cp_cmd, proto::cc_delnet);
-	cmd.add_string(proto::cp_delnet_name, args[0]);
-
-	if (auto error = cmd.error(); error) {
-		xo::emit("{E:/%s: nvlist: %s\n}", getprogname(),
-			 error->message());
-		return 1;
-	}
+	auto cmd = nvl();
+	cmd.add_string(proto::cp_cmd, proto::cc_addrlookup);
+	cmd.add_string(proto::cp_addrlookup_addr, args[0]);
 
 	auto resp = nv_xfer(server, cmd);
-
 	if (!resp) {
 		xo::emit("{E:/%s: failed to send command: %s\n}", getprogname(),
 			 resp.error().message());
 		return 1;
 	}
 
-	if (!resp->exists_string(proto::cp_status)) {
-		xo::emit("{E:/%s: invalid response}", getprogname());
+	if (resp->exists_string(proto::cp_status)
+	    && resp->get_string(proto::cp_status) == proto::cv_status_error) {
+		auto info = resp->exists_string(proto::cp_status_info)
+			  ? resp->get_string(proto::cp_status_info)
+			  : std::string_view("unknown error");
+		xo::emit("{E:/%s: %s}\n", getprogname(), info);
 		return 1;
 	}
 
-	auto status = resp->get_string(proto::cp_status);
+	auto reply = schema::decode(proto::addr_lookup_reply_schema, *resp);
+	if (!reply) {
+		xo::emit("{E:/%s: invalid response: %s}\n", getprogname(),
+			 reply.error().message());
+		return 1;
+	}
 
-	if (status == proto::cv_status_success)
+	if (reply->al_stale.value_or(false))
+		show_stale();
+
+	if (reply->al_addrs.empty())
 		return 0;
 
-	/* we got an error */
-	if (!resp->exists_string(proto::cp_status_info)) {
-		xo::emit("{E:/%s: invalid response}", getprogname());
-		return 1;
+	xo::emit("{T:NAME/%-16s}{T:ADDRESS}\n");
+
+	for (auto &&addr: reply->al_addrs) {
+		auto addr_instance = xo::instance("address");
+		xo::emit("{V:name/%-16s}{V:address/%s}/{V:prefixlen/%ju}\n",
+			 addr.ia_intf, addr.ia_addr, addr.ia_plen);
 	}
 
-	xo::emit("{E:/%s}\n", resp->get_string(proto::cp_status));
-	return 1;
+	return 0;
 }
 
-auto find_command(command const			&root,
-		  std::vector<std::string_view> &args) noexcept
-	-> std::optional<command const *>
+/*
+ * if resp is an error response, print the error and return true.
+ */
+auto is_error(nvl const &resp) noexcept -> bool
 {
-	if (args.empty()) {
-		(void)print(stderr, "incomplete command\n");
-		usage(root);
+	if (!resp.exists_string(proto::cp_status)
+	    || resp.get_string(proto::cp_status) != proto::cv_status_error)
+		return false;
+
+	auto info = resp.exists_string(proto::cp_status_info)
+		  ? resp.get_string(proto::cp_status_info)
+		  : std::string_view("unknown error");
+	xo::emit("{E:/%s: %s}\n", getprogname(), info);
+	return true;
+}
+
+auto emit_route(proto::route const &route) noexcept -> void
+{
+	auto route_instance = xo::instance("route");
+	xo::emit("{V:prefix/%-24s}{V:type/%-12s}{V:gateway/%-24s}"
+		 "{V:interface/%s}\n",
+		 route.rt_prefix, route.rt_type,
+		 route.rt_gateway.value_or("-"), route.rt_intf.value_or("-"));
+}
+
+auto c_route_lookup(connection			     &server,
+		    std::span<std::string_view const> args) noexcept -> int
+{
+	auto xo_guard = xo::xo();
+	auto route_container = xo::container("route-list");
+
+	if (args.size() != 1) {
+		xo::emit("{E/usage: %s route lookup <address>}\n",
+			 getprogname());
+		return 1;
+	}
+
+	auto cmd = nvl();
+	cmd.add_string(proto::cp_cmd, proto::cc_routelookup);
+	cmd.add_string(proto::cp_routelookup_addr, args[0]);
+
+	auto resp = nv_xfer(server, cmd);
+	if (!resp) {
+		xo::emit("{E:/%s: failed to send command: %s\n}", getprogname(),
+			 resp.error().message());
+		return 1;
+	}
+
+	if (is_error(*resp))
+		return 1;
+
+	auto reply = schema::decode(proto::route_schema, *resp);
+	if (!reply) {
+		xo::emit("{E:/%s: invalid response: %s}\n", getprogname(),
+			 reply.error().message());
+		return 1;
+	}
+
+	xo::emit("{T:PREFIX/%-24s}{T:TYPE/%-12s}{T:GATEWAY/%-24s}"
+		 "{T:INTERFACE}\n");
+	emit_route(*reply);
+	return 0;
+}
+
+/*
+ * list routes, fetching them a page at a time since the daemon won't send
+ * a large table in one reply.
+ */
+auto c_route_list(connection			    &server,
+		  std::span<std::string_view const> args) noexcept -> int
+{
+	auto xo_guard = xo::xo();
+	auto route_container = xo::container("route-list");
+
+	if (args.size() > 1) {
+		xo::emit("{E/usage: %s route list [prefix]}\n", getprogname());
+		return 1;
+	}
+
+	auto after = std::optional<std::string>();
+	auto header = false;
+
+	for (;;) {
+		auto cmd = nvl();
+		cmd.add_string(proto::cp_cmd, proto::cc_routelist);
+		cmd.add_number(proto::cp_routelist_limit,
+			       proto::route_list_max_limit);
+		if (!args.empty())
+			cmd.add_string(proto::cp_routelist_prefix, args[0]);
+		if (after)
+			cmd.add_string(proto::cp_routelist_after, *after);
+
+		auto resp = nv_xfer(server, cmd);
+		if (!resp) {
+			xo::emit("{E:/%s: failed to send command: %s\n}",
+				 getprogname(), resp.error().message());
+			return 1;
+		}
+
+		if (is_error(*resp))
+			return 1;
+
+		auto reply = schema::decode(proto::route_list_reply_schema,
+					    *resp);
+		if (!reply) {
+			xo::emit("{E:/%s: invalid response: %s}\n",
+				 getprogname(), reply.error().message());
+			return 1;
+		}
+
+		if (!header && !reply->rl_routes.empty()) {
+			xo::emit("{T:PREFIX/%-24s}{T:TYPE/%-12s}"
+				 "{T:GATEWAY/%-24s}{T:INTERFACE}\n");
+			header = true;
+		}
+
+		for (auto &&route: reply->rl_routes)
+			emit_route(route);
+
+		if (!reply->rl_truncated.value_or(false)
+		    || reply->rl_routes.empty())
+			return 0;
+
+		after = reply->rl_routes.back().rt_prefix;
+	}
+}
+
+auto c_route_stats(connection			    &server,
+		   std::span<std::string_view const> args) noexcept -> int
+{
+	auto xo_guard = xo::xo();
+
+	if (!args.empty()) {
+		xo::emit("{E/usage: %s route stats}\n", getprogname());
+		return 1;
+	}
+
+	auto cmd = nvl();
+	cmd.add_string(proto::cp_cmd, proto::cc_routestats);
+
+	auto resp = nv_xfer(server, cmd);
+	if (!resp) {
+		xo::emit("{E:/%s: failed to send command: %s\n}", getprogname(),
+			 resp.error().message());
+		return 1;
+	}
+
+	if (is_error(*resp))
+		return 1;
+
+	auto reply = schema::decode(proto::route_stats_reply_schema, *resp);
+	if (!reply) {
+		xo::emit("{E:/%s: invalid response: %s}\n", getprogname(),
+			 reply.error().message());
+		return 1;
+	}
+
+	auto stats_container = xo::container("route-stats");
+	xo::emit("{Lwc:IPv4 routes}{V:inet-routes/%ju}\n", reply->rs_inet);
+	xo::emit("{Lwc:IPv6 routes}{V:inet6-routes/%ju}\n", reply->rs_inet6);
+	xo::emit("{Lwc:Next hops}{V:nexthops/%ju}\n", reply->rs_nexthops);
+	xo::emit("{Lwc:RIB memory}{V:rib-bytes/%ju} {U:bytes}\n",
+		 reply->rs_rib_bytes);
+	xo::emit("{Lwc:FIB memory}{V:fib-bytes/%ju} {U:bytes}\n",
+		 reply->rs_fib_bytes);
+	xo::emit("{Lwc:Next hop memory}{V:nexthop-bytes/%ju} {U:bytes}\n",
+		 reply->rs_nh_bytes);
+	return 0;
+}
+
+/*
+ * list neighbours, fetching them a page at a time since the daemon won't
+ * send a large table in one reply.
+ */
+auto c_neigh_list(connection			    &server,
+		  std::span<std::string_view const> args) noexcept -> int
+{
+	auto xo_guard = xo::xo();
+	auto neigh_container = xo::container("neighbor-list");
+
+	auto usage = [] {
+		xo::emit("{E/usage: %s neighbor list [--interface name]"
+			 " [--state state]...}\n",
+			 getprogname());
+		return 1;
+	};
+
+	auto cmd = nvl();
+	cmd.add_string(proto::cp_cmd, proto::cc_neighlist);
+	cmd.add_number(proto::cp_neighlist_limit,
+		       proto::neigh_list_max_limit);
+
+	/* the filters are evaluated by netd */
+	for (auto i = std::size_t{0}; i < args.size(); i += 2) {
+		if (i + 1 == args.size())
+			return usage();
+
+		if (args[i] == "--interface")
+			cmd.add_string(proto::cp_neighlist_intf, args[i + 1]);
+		else if (args[i] == "--state")
+			cmd.append_string_array(proto::cp_neighlist_states,
+						args[i + 1]);
+		else
+			return usage();
+	}
+
+	auto header = false;
+
+	for (;;) {
+		auto resp = nv_xfer(server, cmd);
+		if (!resp) {
+			xo::emit("{E:/%s: failed to send command: %s\n}",
+				 getprogname(), resp.error().message());
+			return 1;
+		}
+
+		if (is_error(*resp))
+			return 1;
+
+		auto reply = schema::decode(proto::neigh_list_reply_schema,
+					    *resp);
+		if (!reply) {
+			xo::emit("{E:/%s: invalid response: %s}\n",
+				 getprogname(), reply.error().message());
+			return 1;
+		}
+
+		if (!header && !reply->nl_neighbors.empty()) {
+			xo::emit("{T:ADDRESS/%-40s}{T:LLADDR/%-20s}"
+				 "{T:INTERFACE/%-16s}{T:STATE}\n");
+			header = true;
+		}
+
+		for (auto &&nb: reply->nl_neighbors) {
+			auto nb_instance = xo::instance("neighbor");
+			xo::emit("{V:address/%-40s}{V:lladdr/%-20s}"
+				 "{V:interface/%-16s}{V:state/%s}"
+				 "{V:router/%s}\n",
+				 nb.nb_addr, nb.nb_lladdr.value_or("-"),
+				 nb.nb_intf, nb.nb_state,
+				 nb.nb_router.value_or(false)
+					 ? std::string_view(" router")
+					 : std::string_view());
+		}
+
+		if (!reply->nl_cursor)
+			return 0;
+
+		if (cmd.exists_number(proto::cp_neighlist_cursor))
+			cmd.free_number(proto::cp_neighlist_cursor);
+		cmd.add_number(proto::cp_neighlist_cursor, *reply->nl_cursor);
+	}
+}
+
+/*
+ * show the daemon's metrics.  a counter only has a value, which is shown as
+ * its count.
+ */
+auto c_daemon_stats(connection			     &server,
+		    std::span<std::string_view const> args) noexcept -> int
+{
+	auto xo_guard = xo::xo();
+
+	if (!args.empty()) {
+		xo::emit("{E/usage: %s daemon stats}\n", getprogname());
+		return 1;
+	}
+
+	auto metrics_container = xo::container("daemon-stats");
+
+	auto cmd = nvl();
+	cmd.add_string(proto::cp_cmd, proto::cc_daemonstats);
+
+	auto header = false;
+
+	for (;;) {
+		auto resp = nv_xfer(server, cmd);
+		if (!resp) {
+			xo::emit("{E:/%s: failed to send command: %s\n}",
+				 getprogname(), resp.error().message());
+			return 1;
+		}
+
+		if (is_error(*resp))
+			return 1;
+
+		auto reply = schema::decode(proto::daemon_stats_reply_schema,
+					    *resp);
+		if (!reply) {
+			xo::emit("{E:/%s: invalid response: %s}\n",
+				 getprogname(), reply.error().message());
+			return 1;
+		}
+
+		if (!header && !reply->ds_metrics.empty()) {
+			xo::emit("{T:NAME/%-32s}{T:COUNT/%12s}{T:P50/%10s}"
+				 "{T:P90/%10s}{T:P99/%10s}{T:P99.9/%10s}"
+				 "{T:MAX/%10s} {T:UNIT}\n");
+			header = true;
+		}
+
+		for (auto &&m: reply->ds_metrics) {
+			auto m_instance = xo::instance("metric");
+			auto show = [](std::optional<std::uint64_t> v) {
+				return v ? std::to_string(*v)
+					 : std::string("-");
+			};
+
+			xo::emit("{V:name/%-32s}{V:count/%12s}{V:p50/%10s}"
+				 "{V:p90/%10s}{V:p99/%10s}{V:p999/%10s}"
+				 "{V:max/%10s} {V:unit/%s}\n",
+				 m.m_name, show(m.m_value ? m.m_value
+							  : m.m_count),
+				 show(m.m_p50), show(m.m_p90), show(m.m_p99),
+				 show(m.m_p999), show(m.m_max),
+				 m.m_unit.value_or(""));
+		}
+
+		if (!reply->ds_cursor)
+			return 0;
+
+		if (cmd.exists_number(proto::cp_daemonstats_cursor))
+			cmd.free_number(proto::cp_daemonstats_cursor);
+		cmd.add_number(proto::cp_daemonstats_cursor,
+			       *reply->ds_cursor);
+	}
+}
+
+/*
+ * bench: a load generator for the control socket.  each connection is driven
+ * by its own thread, which sends a random mix of requests, either as fast as
+ * the server answers them or paced to a target rate.
+ *
+ * when pacing, latency is measured from when the request was due to be sent
+ * rather than when it was sent, so a slow server is charged for the requests
+ * it delayed as well as the ones it was slow to answer.
+ */
+
+enum struct bench_op : std::uint8_t {
+	intf_list,
+	net_list,
+	net_create,
+	net_delete,
+};
+
+constexpr auto bench_op_names =
+	std::array{"intf"sv, "net"sv, "create"sv, "delete"sv};
+
+/* a count for each operation */
+using bench_counts = std::array<std::uint64_t, bench_op_names.size()>;
+
+struct bench_config {
+	std::uint64_t bc_connections = 1;
+	std::uint64_t bc_requests = 0; /* per connection; 0 to use duration */
+	std::chrono::seconds bc_duration{10};
+	double		     bc_rate = 0; /* in total; 0 is flat out */
+	std::array<unsigned, bench_op_names.size()> bc_mix{70, 20, 5, 5};
+};
+
+struct bench_worker {
+	explicit bench_worker(std::size_t id) noexcept : bw_id(id) {}
+
+	std::size_t		   bw_id;
+	connection		   bw_conn;
+	std::vector<std::uint64_t> bw_latency; /* nanoseconds */
+	bench_counts		   bw_count{};
+	bench_counts		   bw_errors{};
+	std::vector<std::string>   bw_nets; /* networks we created */
+	std::uint64_t		   bw_seq = 0;
+};
+
+auto parse_uint(std::string_view str) noexcept -> std::optional<std::uint64_t>
+{
+	auto value = std::uint64_t{};
+	auto [ptr, ec] =
+		std::from_chars(str.data(), str.data() + str.size(), value);
+	if (ec != std::errc() || ptr != str.data() + str.size())
 		return {};
+	return value;
+}
+
+/* parse a mix such as "intf=70,net=20,create=5,delete=5" */
+auto parse_mix(std::string_view str, bench_config &config) noexcept -> bool
+{
+	config.bc_mix = {};
+
+	for (auto &&part: str | std::views::split(',')) {
+		auto item = std::string_view(part);
+		auto eq = item.find('=');
+		if (eq == item.npos)
+			return false;
+
+		auto op = std::ranges::find(bench_op_names, item.substr(0, eq));
+		auto weight = parse_uint(item.substr(eq + 1));
+		if (op == bench_op_names.end() || !weight || *weight > 1000)
+			return false;
+
+		config.bc_mix[static_cast<std::size_t>(
+			op - bench_op_names.begin())] =
+			static_cast<unsigned>(*weight);
+	}
+
+	return std::ranges::any_of(config.bc_mix,
+				   [](unsigned w) { return w > 0; });
+}
+
+/* build the request for an operation */
+auto bench_request(bench_worker &worker, bench_op op) -> nvl
+{
+	auto cmd = nvl();
+
+	switch (op) {
+	case bench_op::intf_list:
+		cmd.add_string(proto::cp_cmd, proto::cc_getifs);
+		break;
+
+	case bench_op::net_list:
+		cmd.add_string(proto::cp_cmd, proto::cc_getnets);
+		break;
+
+	case bench_op::net_create:
+		worker.bw_nets.push_back(
+			std::format("nb{}-{}", worker.bw_id, worker.bw_seq++));
+		cmd.add_string(proto::cp_cmd, proto::cc_newnet);
+		cmd.add_string(proto::cp_newnet_name, worker.bw_nets.back());
+		break;
+
+	case bench_op::net_delete:
+		cmd.add_string(proto::cp_cmd, proto::cc_delnet);
+		cmd.add_string(proto::cp_delnet_name, worker.bw_nets.back());
+		worker.bw_nets.pop_back();
+		break;
+	}
+
+	return cmd;
+}
+
+/* an error reply; unlike is_error(), this doesn't print anything */
+auto bench_failed(nvl const &resp) noexcept -> bool
+{
+	return resp.exists_string(proto::cp_status)
+	    && resp.get_string(proto::cp_status) == proto::cv_status_error;
+}
+
+auto bench_run(bench_config const &config, bench_worker &worker,
+	       std::latch &ready) -> void
+{
+	using clock = std::chrono::steady_clock;
+
+	auto rng = std::mt19937_64(worker.bw_id);
+	auto pick = std::discrete_distribution<std::size_t>(
+		config.bc_mix.begin(), config.bc_mix.end());
+
+	auto interval = config.bc_rate > 0
+			      ? std::chrono::duration_cast<clock::duration>(
+					std::chrono::duration<double>(
+						static_cast<double>(
+							config.bc_connections)
+						/ config.bc_rate))
+			      : clock::duration::zero();
+
+	ready.arrive_and_wait();
+
+	auto start = clock::now();
+	auto due = start;
+
+	for (auto n = std::uint64_t{0};; ++n) {
+		if (config.bc_requests > 0 ? n == config.bc_requests
+					   : clock::now() - start
+						     >= config.bc_duration)
+			break;
+
+		auto op = static_cast<bench_op>(pick(rng));
+		/* there's nothing to delete until we've created something */
+		if (op == bench_op::net_delete && worker.bw_nets.empty())
+			op = bench_op::net_create;
+
+		auto cmd = bench_request(worker, op);
+
+		if (interval > clock::duration::zero()) {
+			std::this_thread::sleep_until(due);
+			due += interval;
+		} else {
+			due = clock::now();
+		}
+
+		auto resp = nv_xfer(worker.bw_conn, cmd);
+		auto elapsed = clock::now() - due;
+
+		auto i = static_cast<std::size_t>(op);
+		++worker.bw_count[i];
+		if (!resp || bench_failed(*resp))
+			++worker.bw_errors[i];
+
+		worker.bw_latency.push_back(static_cast<std::uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(
+				elapsed)
+				.count()));
+	}
+
+	/* remove whatever we left behind; this isn't measured */
+	while (!worker.bw_nets.empty())
+		(void)nv_xfer(worker.bw_conn,
+			      bench_request(worker, bench_op::net_delete));
+}
+
+auto c_bench(connection			      & /*server*/,
+	     std::span<std::string_view const> args) noexcept -> int
+try {
+	auto xo_guard = xo::xo();
+
+	auto usage = [] {
+		xo::emit("{E/usage: %s bench [--connections n]"
+			 " [--duration seconds | --requests n] [--rate n]"
+			 " [--mix op=weight,...]}\n",
+			 getprogname());
+		return 1;
+	};
+
+	auto config = bench_config();
+
+	for (auto i = std::size_t{0}; i < args.size(); i += 2) {
+		if (i + 1 == args.size())
+			return usage();
+
+		auto value = args[i + 1];
+		auto number = parse_uint(value);
+
+		if (args[i] == "--connections" && number && *number > 0)
+			config.bc_connections = *number;
+		else if (args[i] == "--duration" && number && *number > 0)
+			config.bc_duration = std::chrono::seconds(*number);
+		else if (args[i] == "--requests" && number && *number > 0)
+			config.bc_requests = *number;
+		else if (args[i] == "--rate" && number)
+			config.bc_rate = static_cast<double>(*number);
+		else if (args[i] == "--mix" && parse_mix(value, config))
+			continue;
+		else
+			return usage();
 	}
 
+	/*
+	 * connect everything before starting, so the connection storm isn't
+	 * part of the measurement.
+	 */
+	auto workers = std::vector<std::unique_ptr<bench_worker>>();
+
+	for (auto i = std::size_t{0}; i < config.bc_connections; ++i) {
+		auto &worker = *workers.emplace_back(
+			std::make_unique<bench_worker>(i));
+		if (auto fd = worker.bw_conn.get(); !fd) {
+			xo::emit("{E:/%s: connect: %s}\n", getprogname(),
+				 fd.error().message());
+			return 1;
+		}
+	}
+
+	auto ready =
+		std::latch(static_cast<std::ptrdiff_t>(workers.size() + 1));
+	auto threads = std::vector<std::jthread>();
+
+	for (auto &&worker: workers)
+		threads.emplace_back(
+			[&] { bench_run(config, *worker, ready); });
+
+	ready.arrive_and_wait();
+	auto start = std::chrono::steady_clock::now();
+	threads.clear(); /* joins */
+	auto elapsed = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start);
+
+	/* merge the results */
+	auto latency = std::vector<std::uint64_t>();
+	auto count = bench_counts{};
+	auto errors = bench_counts{};
+
+	for (auto &&worker: workers) {
+		latency.insert(latency.end(), worker->bw_latency.begin(),
+			       worker->bw_latency.end());
+		for (auto i = std::size_t{0}; i < bench_op_names.size(); ++i) {
+			count[i] += worker->bw_count[i];
+			errors[i] += worker->bw_errors[i];
+		}
+	}
+
+	std::ranges::sort(latency);
+
+	/* the latency at a rank given in thousandths, in microseconds */
+	auto percentile = [&](std::size_t rank) {
+		if (latency.empty())
+			return 0.0;
+		auto i = std::min(latency.size() * rank / 1000,
+				  latency.size() - 1);
+		return static_cast<double>(latency[i]) / 1000;
+	};
+
+	auto total = latency.size();
+	auto bench_container = xo::container("bench");
+
+	xo::emit("{Lwc:Connections}{V:connections/%ju}\n",
+		 config.bc_connections);
+	xo::emit("{Lwc:Requests}{V:requests/%zu}\n", total);
+	xo::emit("{Lwc:Errors}{V:errors/%ju}\n",
+		 std::ranges::fold_left(errors, std::uint64_t{0},
+					std::plus<>()));
+	xo::emit("{Lwc:Elapsed}{V:elapsed/%.2f} {U:s}\n", elapsed.count());
+	xo::emit("{Lwc:Throughput}{V:throughput/%.0f}"
+		 " {U:requests per second}\n",
+		 static_cast<double>(total) / elapsed.count());
+	xo::emit("{Lwc:Latency p50}{V:p50/%.1f} {U:us}\n", percentile(500));
+	xo::emit("{Lwc:Latency p99}{V:p99/%.1f} {U:us}\n", percentile(990));
+	xo::emit("{Lwc:Latency p99.9}{V:p999/%.1f} {U:us}\n",
+		 percentile(999));
+	xo::emit("{Lwc:Latency max}{V:max/%.1f} {U:us}\n",
+		 latency.empty() ? 0.0
+				 : static_cast<double>(latency.back()) / 1000);
+
+	xo::emit("\n{T:OPERATION/%-12s}{T:REQUESTS/%12s}{T:ERRORS/%12s}\n");
+	for (auto i = std::size_t{0}; i < bench_op_names.size(); ++i) {
+		auto op_instance = xo::instance("operation");
+		xo::emit("{V:name/%-12s}{V:requests/%12ju}{V:errors/%12ju}\n",
+			 bench_op_names[i], count[i], errors[i]);
+	}
+
+	return 0;
+} catch (std::system_error const &exc) {
+	xo::emit("{E:/%s: %s}\n", getprogname(), exc.what());
+	return 1;
+}
+
+/*
+ * find the command named by args, and remove its name from args.
+ */
+auto resolve_command(command const		       &root,
+		     std::vector<std::string_view> &args) noexcept
+	-> std::expected<command const *, std::string>
+try {
 	auto const *cur = &root;
 
 	while (!args.empty()) {
 		auto match = cur->match(args[0]);
-
-		if (!match) {
-			(void)print(stderr, "{}\n", match.error());
-			return {};
-		}
+		if (!match)
+			return std::unexpected(match.error());
 
 		cur = *match;
 
@@ -463,27 +1562,244 @@ auto find_command(command const			&root,
 			return cur;
 		}
 
-		if (args.size() == 1) {
-			(void)print(stderr, "{}: incomplete command\n",
-				    args[0]);
-			return {};
-		}
+		if (args.size() == 1)
+			return std::unexpected(
+				std::format("{}: incomplete command", args[0]));
 
 		args.erase(args.begin());
 	}
 
-	return {};
+	return std::unexpected("incomplete command"s);
+} catch (std::bad_alloc const &) {
+	abort();
 }
 
-auto netd_connect() noexcept -> int
+auto find_command(command const			&root,
+		  std::vector<std::string_view> &args) noexcept
+	-> std::optional<command const *>
 {
+	if (args.empty()) {
+		(void)print(stderr, "incomplete command\n");
+		usage(root);
+		return {};
+	}
 
-	auto sock = socket(AF_UNIX, SOCK_SEQPACKET, 0);
-	if (sock == -1) {
-		perror("socket");
-		return -1;
+	auto cmd = resolve_command(root, args);
+	if (!cmd) {
+		(void)print(stderr, "{}\n", cmd.error());
+		return {};
 	}
 
+	return *cmd;
+}
+
+/*
+ * batch mode: read commands from a file, one per line, and send them all over
+ * one connection.  commands are pipelined: up to batch_window requests are
+ * sent before waiting for the first reply, and replies are read as they
+ * arrive.  netd answers the commands on a connection in order, so each reply
+ * belongs to the oldest request still waiting.
+ *
+ * only commands which are given as a reqbuilder can be used in a batch.  blank
+ * lines and lines starting with '#' are ignored.
+ */
+
+constexpr std::size_t batch_window = 64;
+
+struct batch_entry {
+	std::size_t		   be_line;
+	std::string		   be_text;
+	std::vector<std::byte>	   be_request; /* empty once it's been sent */
+	std::optional<std::string> be_error;
+	bool			   be_done = false;
+};
+
+/* parse a line into a batch entry, with either a request or an error */
+auto batch_parse(command const &root, std::size_t lineno, std::string line)
+	-> batch_entry
+{
+	auto entry = batch_entry{.be_line = lineno, .be_text = std::move(line)};
+
+	auto args = entry.be_text | std::views::split(' ')
+		  | std::views::filter([](auto &&w) { return !w.empty(); })
+		  | std::views::transform(
+			    [](auto &&w) { return std::string_view(w); })
+		  | std::ranges::to<std::vector>();
+
+	auto fail = [&](std::string error) {
+		entry.be_error = std::move(error);
+		entry.be_done = true;
+		return std::move(entry);
+	};
+
+	auto cmd = resolve_command(root, args);
+	if (!cmd)
+		return fail(cmd.error());
+
+	if (!(*cmd)->cm_request)
+		return fail("command can't be used in a batch");
+
+	auto request = (*cmd)->cm_request(args);
+	if (!request)
+		return fail(request.error());
+
+	auto packed = request->pack();
+	if (!packed)
+		return fail(packed.error().message());
+
+	entry.be_request = std::move(*packed);
+	return entry;
+}
+
+auto batch_report(batch_entry const &entry) -> void
+{
+	auto line_instance = xo::instance("line");
+
+	if (entry.be_error)
+		xo::emit("{V:line/%zu}: {V:status/%s}: {V:command/%s}:"
+			 " {V:error/%s}\n",
+			 entry.be_line, "error", entry.be_text,
+			 *entry.be_error);
+	else
+		xo::emit("{V:line/%zu}: {V:status/%s}: {V:command/%s}\n",
+			 entry.be_line, "ok", entry.be_text);
+}
+
+auto c_batch(command const &root, connection &conn, std::istream &input)
+	-> int
+{
+	auto xo_guard = xo::xo();
+	auto batch_container = xo::container("batch");
+
+	auto server = conn.get();
+	if (!server) {
+		xo::emit("{E:/%s: connect: %s}\n", getprogname(),
+			 server.error().message());
+		return 1;
+	}
+
+	auto queue = std::deque<batch_entry>();
+	auto nsent = std::size_t{0}; /* the entries at the front already sent */
+	auto lineno = std::size_t{0};
+	auto eof = false;
+	auto ncommands = std::size_t{0};
+	auto nfailed = std::size_t{0};
+	auto line = std::string();
+
+	for (;;) {
+		/* read more commands if the window has room */
+		while (!eof && queue.size() < batch_window) {
+			if (!std::getline(input, line)) {
+				eof = true;
+				break;
+			}
+
+			++lineno;
+			if (line.empty() || line.starts_with('#')
+			    || line.find_first_not_of(" \t") == line.npos)
+				continue;
+
+			std::ranges::replace(line, '\t', ' ');
+			queue.push_back(batch_parse(root, lineno, line));
+		}
+
+		/* report whatever is finished, in order */
+		while (!queue.empty() && queue.front().be_done) {
+			batch_report(queue.front());
+			++ncommands;
+			if (queue.front().be_error)
+				++nfailed;
+
+			queue.pop_front();
+			if (nsent > 0)
+				--nsent;
+		}
+
+		if (queue.empty()) {
+			if (eof)
+				break;
+			continue;
+		}
+
+		/* skip over anything which failed before it was sent */
+		while (nsent < queue.size() && queue[nsent].be_done)
+			++nsent;
+
+		auto not_done = [](batch_entry const &e) { return !e.be_done; };
+		auto last_sent = std::next(queue.begin(),
+					   static_cast<std::ptrdiff_t>(nsent));
+		auto waiting = std::any_of(queue.begin(), last_sent, not_done);
+
+		auto pfd = pollfd{.fd = *server, .events = 0, .revents = 0};
+		if (nsent < queue.size())
+			pfd.events |= POLLOUT;
+		if (waiting)
+			pfd.events |= POLLIN;
+
+		if (::poll(&pfd, 1, -1) == -1) {
+			if (errno == EINTR)
+				continue;
+			xo::emit("{E:/%s: poll: %s}\n", getprogname(),
+				 error::strerror());
+			return 1;
+		}
+
+		if ((pfd.revents & POLLOUT) != 0 && nsent < queue.size()) {
+			auto &entry = queue[nsent];
+			auto ret = send_msg(*server, entry.be_request,
+					    MSG_DONTWAIT);
+
+			/* if the socket is full, wait for it to drain */
+			constexpr auto again =
+				std::errc::resource_unavailable_try_again;
+			auto full = !ret && ret.error() == again;
+
+			if (!ret && !full) {
+				xo::emit("{E:/%s: send: %s}\n", getprogname(),
+					 ret.error().message());
+				return 1;
+			}
+
+			if (ret) {
+				entry.be_request = {};
+				++nsent;
+			}
+		}
+
+		if ((pfd.revents & (POLLIN | POLLHUP)) != 0 && waiting) {
+			auto resp = recv_msg(*server);
+			if (!resp) {
+				xo::emit("{E:/%s: receive: %s}\n",
+					 getprogname(), resp.error().message());
+				return 1;
+			}
+
+			/* the oldest request waiting for a reply */
+			auto &entry = *std::find_if(queue.begin(), last_sent,
+						    not_done);
+
+			auto reply = nvl::unpack(*resp);
+			if (!reply)
+				entry.be_error = reply.error().message();
+			else if (auto status = reply_status(*reply); !status)
+				entry.be_error = status.error();
+			entry.be_done = true;
+		}
+	}
+
+	auto summary_container = xo::container("summary");
+	xo::emit("{Lwc:Commands}{V:commands/%zu}\n", ncommands);
+	xo::emit("{Lwc:Failed}{V:failed/%zu}\n", nfailed);
+
+	return nfailed > 0 ? 1 : 0;
+}
+
+auto netd_connect() noexcept -> std::expected<int, std::error_code>
+{
+	auto sock = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+	if (sock == -1)
+		return std::unexpected(error::from_errno());
+
 	auto sun = sockaddr_un{};
 	sun.sun_family = AF_UNIX;
 	static_assert(proto::socket_path.size() < sizeof(sun.sun_path));
@@ -492,9 +1808,9 @@ auto netd_connect() noexcept -> int
 	auto i = connect(sock, reinterpret_cast<sockaddr *>(&sun),
 			 static_cast<socklen_t>(SUN_LEN(&sun)));
 	if (i == -1) {
-		perror("connect");
+		auto err = error::from_errno();
 		::close(sock);
-		return -1;
+		return std::unexpected(err);
 	}
 
 	return sock;
@@ -525,20 +1841,73 @@ try {
 {"interface"sv, command("configure layer 2 interfaces"sv,
 	 command::cmdmap{
 		 {"list"sv, command("list interfaces"sv,
-				    c_intf_list)}})
+				    c_intf_list)},
+		 {"memory"sv, command("show interface database memory use"sv,
+				      c_intf_memory)}})
+},
+{"address"sv, command("query interface addresses"sv,
+	 command::cmdmap{
+		 {"lookup"sv, command("find addresses by address or prefix"sv,
+				      c_addr_lookup)}})
+},
+{"route"sv, command("query the routing table"sv,
+	 command::cmdmap{
+		 {"lookup"sv, command("find the route for an address"sv,
+				      c_route_lookup)},
+		 {"list"sv, command("list routes"sv,
+				    c_route_list)},
+		 {"stats"sv, command("show routing table statistics"sv,
+				     c_route_stats)}})
+},
+{"neighbor"sv, command("query the neighbor cache"sv,
+	 command::cmdmap{
+		 {"list"sv, command("list neighbors"sv,
+				    c_neigh_list)}})
+},
+{"bench"sv, command("generate load on the control socket"sv,
+	 c_bench)
+},
+{"daemon"sv, command("query the daemon"sv,
+	 command::cmdmap{
+		 {"stats"sv, command("show daemon metrics"sv,
+				     c_daemon_stats)}})
 },
 {"network"sv, command("configure layer 3 networks"sv,
 	 command::cmdmap{
 		 {"list"sv, command("list networks"sv,
 				    c_net_list)},
 		 {"create"sv, command("create new network"sv,
-				      c_net_create)},
+				      r_net_create)},
 		 {"delete"sv, command("delete existing network"sv,
-				      c_net_delete)},
+				      r_net_delete)},
+		 {"txn"sv, command("create and delete networks atomically"sv,
+				   r_net_txn)},
 	 })}
 });
 	// clang-format on
 
+	/* -f file runs a batch of commands from the file, or stdin for - */
+	if (!args.empty() && args[0] == "-f") {
+		if (args.size() != 2) {
+			usage(root_cmd);
+			return 1;
+		}
+
+		auto server = connection();
+
+		if (args[1] == "-")
+			return c_batch(root_cmd, server, std::cin);
+
+		auto input = std::ifstream(std::string(args[1]));
+		if (!input) {
+			(void)print(stderr, "{}: {}: {}\n", getprogname(),
+				    args[1], error::strerror());
+			return 1;
+		}
+
+		return c_batch(root_cmd, server, input);
+	}
+
 	if (args.empty()) {
 		usage(root_cmd);
 		return 1;
@@ -548,10 +1917,7 @@ try {
 	if (!cmd)
 		return 1;
 
-	auto server = netd_connect();
-	if (server == -1)
-		return 1;
-
+	auto server = connection();
 	return (*cmd)->cm_handler(server, args);
 } catch (std::exception const &exc) {
 	(void)netd::panic("unhandled exception: {}", exc.what());
@@ -0,0 +1,77 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of
+ * this software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at
+ * large and to the detriment of our heirs and successors. We intend this
+ * dedication to be an overt act of relinquishment in perpetuity of all present
+ * and future rights to this software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * count heap allocations, so benchmarks can report allocations per operation.
+ *
+ * this replaces the libc allocation functions with versions which bump a
+ * counter and then call jemalloc's own entry points, which FreeBSD's libc
+ * exports under these names.  libnv and operator new both allocate through
+ * malloc(), so this catches both.  free() is left alone.
+ */
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <cstddef>
+
+import bench;
+
+extern "C" {
+
+auto __malloc(std::size_t) -> void *;
+auto __calloc(std::size_t, std::size_t) -> void *;
+auto __realloc(void *, std::size_t) -> void *;
+auto __aligned_alloc(std::size_t, std::size_t) -> void *;
+auto __posix_memalign(void **, std::size_t, std::size_t) -> int;
+
+auto malloc(std::size_t size) -> void *
+{
+	netd::bench::allocations.fetch_add(1, std::memory_order_relaxed);
+	return __malloc(size);
+}
+
+auto calloc(std::size_t nitems, std::size_t size) -> void *
+{
+	netd::bench::allocations.fetch_add(1, std::memory_order_relaxed);
+	return __calloc(nitems, size);
+}
+
+auto realloc(void *ptr, std::size_t size) -> void *
+{
+	netd::bench::allocations.fetch_add(1, std::memory_order_relaxed);
+	return __realloc(ptr, size);
+}
+
+auto aligned_alloc(std::size_t align, std::size_t size) -> void *
+{
+	netd::bench::allocations.fetch_add(1, std::memory_order_relaxed);
+	return __aligned_alloc(align, size);
+}
+
+auto posix_memalign(void **ptr, std::size_t align, std::size_t size) -> int
+{
+	netd::bench::allocations.fetch_add(1, std::memory_order_relaxed);
+	return __posix_memalign(ptr, align, size);
+}
+
+} // extern "C"
@@ -0,0 +1,167 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of
+ * this software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at
+ * large and to the detriment of our heirs and successors. We intend this
+ * dedication to be an overt act of relinquishment in perpetuity of all present
+ * and future rights to this software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * the persistent database with 100,000 networks, stored on the local
+ * filesystem under /tmp: startup from a journal or from a snapshot, and
+ * committing changes one at a time or in groups.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <expected>
+#include <format>
+#include <print>
+#include <string>
+#include <system_error>
+#include <vector>
+
+import bench;
+import db;
+import netd.network;
+import netd.util;
+
+namespace netd::bench {
+
+namespace {
+
+/* the number of networks in the database */
+constexpr std::uint64_t nnets = 100'000;
+
+/* the number of changes committed together in the group commit benchmark */
+constexpr std::uint64_t group_size = 64;
+
+/* a temporary database directory, removed at exit */
+struct tmpdir {
+	tmpdir()
+	{
+		auto tmpl = std::string("/tmp/netd-bench.XXXXXX");
+		if (::mkdtemp(tmpl.data()) == nullptr)
+			panic("mkdtemp: {}", error::strerror());
+		td_path = tmpl;
+	}
+
+	tmpdir(tmpdir const &) = delete;
+	auto operator=(tmpdir const &) -> tmpdir & = delete;
+
+	~tmpdir()
+	{
+		auto dfd = ::open(td_path.c_str(), O_RDONLY | O_DIRECTORY);
+		if (dfd != -1) {
+			for (auto name: {"journal", "snapshot", "snapshot.new"})
+				(void)::unlinkat(dfd, name, 0);
+			::close(dfd);
+		}
+		(void)::rmdir(td_path.c_str());
+	}
+
+	std::string td_path;
+};
+
+auto const journal_dir = tmpdir();
+auto const snapshot_dir = tmpdir();
+auto const commit_dir = tmpdir();
+
+auto check(std::expected<void, std::error_code> const &ret) -> void
+{
+	if (!ret)
+		panic("db: {}", ret.error().message());
+}
+
+auto create_networks() -> void
+{
+	for (auto i = std::uint64_t{0}; i < nnets; ++i)
+		if (!network::create(std::format("net{}", i)))
+			panic("network::create failed");
+}
+
+/*
+ * write the same 100,000 networks as a snapshot in one directory and as a
+ * journal in another.
+ */
+auto populate() -> bool
+{
+	check(db::init(snapshot_dir.td_path));
+	create_networks();
+	check(db::save());
+
+	/* this empties the configuration, since the directory is empty */
+	check(db::init(journal_dir.td_path));
+	create_networks();
+	check(db::flush());
+
+	std::println(stderr, "db: {} networks, {} byte journal", nnets,
+		     db::get_stats().st_journal_bytes);
+	return true;
+}
+
+auto const populated = populate();
+
+/*
+ * add and remove networks, waiting for each group of changes to reach the
+ * disk.  snapshot afterwards so the journal doesn't grow between runs.
+ */
+auto churn(std::uint64_t n, std::uint64_t group) -> void
+{
+	check(db::init(commit_dir.td_path));
+
+	auto nets = std::vector<network::handle>();
+	nets.reserve(group);
+
+	while (n--) {
+		for (auto i = std::uint64_t{0}; i < group; ++i)
+			nets.push_back(*network::create(std::format("c{}", i)));
+		check(db::flush());
+
+		for (auto &&net: nets)
+			network::remove(net);
+		nets.clear();
+		check(db::flush());
+	}
+
+	check(db::save());
+}
+
+auto const registered = add("db/startup/journal", nnets,
+			    [](std::uint64_t n) {
+				    while (n--)
+					    check(db::init(
+						    journal_dir.td_path));
+			    })
+		     && add("db/startup/snapshot", nnets,
+			    [](std::uint64_t n) {
+				    while (n--)
+					    check(db::init(
+						    snapshot_dir.td_path));
+			    })
+		     && add("db/commit/single", 2,
+			    [](std::uint64_t n) { churn(n, 1); })
+		     && add("db/commit/group", group_size * 2,
+			    [](std::uint64_t n) { churn(n, group_size); });
+
+} // namespace
+
+} // namespace netd::bench
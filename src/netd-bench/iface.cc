@@ -0,0 +1,164 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of
+ * this software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at
+ * large and to the detriment of our heirs and successors. We intend this
+ * dedication to be an overt act of relinquishment in perpetuity of all present
+ * and future rights to this software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * walk the interface database, comparing the copying info() interface with
+ * the borrowing visit() interface and with a published snapshot; and time
+ * publishing a snapshot.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include <net/if.h>
+
+#include <netlink/netlink.h>
+#include <netlink/route/interface.h>
+
+#include <cstdint>
+#include <format>
+#include <utility>
+
+import bench;
+import iface;
+import netlink;
+
+namespace netd::bench {
+
+namespace {
+
+/* the number of interfaces in the database */
+constexpr std::uint64_t nintfs = 10'000;
+
+/*
+ * fill the interface database by sending it the same events netlink would.
+ * iface::init() also queues the stats task, but that never runs since we
+ * don't start the event loop.
+ */
+auto populate() -> bool
+{
+	(void)iface::init();
+
+	auto batch = netlink::link_batch();
+
+	for (auto i = std::uint64_t{0}; i < nintfs; ++i) {
+		auto msg = netlink::newlink_data{};
+		msg.nl_ifindex = static_cast<int>(i + 1);
+		msg.nl_ifname = std::format("vtnet{}", i);
+		msg.nl_kind = "vtnet";
+		msg.nl_operstate = IF_OPER_UP;
+		msg.nl_flags = IFF_UP;
+
+		batch.lb_changes.push_back({.lc_ifindex = msg.nl_ifindex,
+					    .lc_link = std::move(msg)});
+		++batch.lb_msgs;
+	}
+
+	netlink::evt_links.dispatch(batch);
+
+	/* the event loop would publish this once the batch was done */
+	iface::publish_snapshot();
+	return true;
+}
+
+auto const populated = populate();
+
+auto walk_info() -> std::uint64_t
+{
+	auto sum = std::uint64_t{0};
+
+	for (auto &&hdl: iface::getall()) {
+		auto iinfo = iface::info(hdl);
+		sum += iinfo.name.size() + iinfo.rx_bps + iinfo.tx_bps
+		     + iface::oper_state(iinfo);
+	}
+
+	return sum;
+}
+
+auto walk_visit() -> std::uint64_t
+{
+	auto sum = std::uint64_t{0};
+
+	iface::visit([&](iface::ifview const &intf) {
+		sum += intf.name.size() + intf.rx_bps + intf.tx_bps
+		     + iface::oper_state(intf);
+	});
+
+	return sum;
+}
+
+auto walk_snapshot() -> std::uint64_t
+{
+	auto sum = std::uint64_t{0};
+	auto snap = iface::read_snapshot();
+
+	for (auto &&intf: snap->sn_intfs)
+		sum += intf.name.size() + intf.rx_bps + intf.tx_bps
+		     + iface::oper_state(intf);
+
+	return sum;
+}
+
+/* matches vtnet10, vtnet100-109 and vtnet1000-1099 */
+auto const prefix_filter = iface::filter{.f_name = "vtnet10*"};
+
+auto walk_prefix() -> std::uint64_t
+{
+	auto sum = std::uint64_t{0};
+
+	iface::visit_if(prefix_filter, [&](iface::ifview const &intf) {
+		sum += intf.name.size() + intf.rx_bps + intf.tx_bps;
+	});
+
+	return sum;
+}
+
+auto const registered = add("iface/walk/info", nintfs,
+			    [](std::uint64_t n) {
+				    while (n--)
+					    keep(walk_info());
+			    })
+		     && add("iface/walk/visit", nintfs,
+			    [](std::uint64_t n) {
+				    while (n--)
+					    keep(walk_visit());
+			    })
+		     && add("iface/walk/snapshot", nintfs,
+			    [](std::uint64_t n) {
+				    while (n--)
+					    keep(walk_snapshot());
+			    })
+		     && add("iface/snapshot/publish", nintfs,
+			    [](std::uint64_t n) {
+				    while (n--)
+					    iface::publish_snapshot();
+			    })
+		     && add("iface/walk/visit_if/prefix", 111,
+			    [](std::uint64_t n) {
+				    while (n--)
+					    keep(walk_prefix());
+			    });
+
+} // namespace
+
+} // namespace netd::bench
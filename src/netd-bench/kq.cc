@@ -0,0 +1,167 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of
+ * this software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at
+ * large and to the detriment of our heirs and successors. We intend this
+ * dedication to be an overt act of relinquishment in perpetuity of all present
+ * and future rights to this software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * the event loop: the cost of starting a task and resuming it through the
+ * dispatch queue, of a timer round trip through the kernel, of running a task
+ * under a timeout which doesn't expire, and of the when_all() and task_group
+ * combinators.
+ *
+ * each run starts the loop, and a task stops it once the work is done.  the
+ * background tasks other benchmarks queue (the interface stats task, the
+ * database flusher) also run here; they spend the whole run asleep or idle,
+ * so they don't disturb the result.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <system_error>
+
+import bench;
+import netd.async;
+import netd.util;
+
+namespace netd::bench {
+
+namespace {
+
+auto init() -> void
+{
+	static auto const initialised = [] {
+		if (auto ret = kq::init(); !ret)
+			panic("kq::init: {}", ret.error().message());
+		return true;
+	}();
+
+	keep(initialised);
+}
+
+auto loop() -> void
+{
+	if (auto ret = kq::run(); !ret)
+		panic("kq::run: {}", ret.error().message());
+}
+
+auto nop() -> jtask<void>
+{
+	co_return;
+}
+
+auto stopper() -> jtask<void>
+{
+	kq::stop();
+	co_return;
+}
+
+/* start n tasks which finish immediately */
+auto spawn(std::uint64_t n) -> void
+{
+	init();
+
+	while (n--)
+		kq::run_task(nop());
+
+	kq::run_task(stopper());
+	loop();
+}
+
+/* wait for n timers which expire immediately, one after another */
+auto timers(std::uint64_t n) -> jtask<void>
+{
+	while (n--)
+		co_await kq::sleep(std::chrono::nanoseconds(0));
+
+	kq::stop();
+}
+
+auto finish() -> task<int>
+{
+	co_return 0;
+}
+
+/* run n tasks which finish at once, each under a timeout */
+auto timeouts(std::uint64_t n) -> jtask<void>
+{
+	while (n--) {
+		auto ret = co_await kq::with_timeout(finish(),
+						     std::chrono::seconds(1));
+		keep(ret);
+	}
+
+	kq::stop();
+}
+
+/* wait for n sets of four tasks, all of which finish at once */
+auto joins(std::uint64_t n) -> jtask<void>
+{
+	while (n--) {
+		auto ret = co_await kq::when_all(finish(), finish(), finish(),
+						 finish());
+		keep(ret);
+	}
+
+	kq::stop();
+}
+
+auto succeed() -> task<std::expected<void, std::error_code>>
+{
+	co_return {};
+}
+
+/* run n tasks through a group, four at a time */
+auto groups(std::uint64_t n) -> jtask<void>
+{
+	auto group = kq::task_group(4);
+
+	while (n--)
+		co_await group.spawn(succeed());
+
+	keep(co_await group.join());
+	kq::stop();
+}
+
+auto const registered = add("kq/task/spawn", 1, spawn)
+		     && add("kq/timer", 1, [](std::uint64_t n) {
+				init();
+				kq::run_task(timers(n));
+				loop();
+			})
+		     && add("kq/timeout", 1, [](std::uint64_t n) {
+				init();
+				kq::run_task(timeouts(n));
+				loop();
+			})
+		     && add("kq/when_all", 4, [](std::uint64_t n) {
+				init();
+				kq::run_task(joins(n));
+				loop();
+			})
+		     && add("kq/task_group", 1, [](std::uint64_t n) {
+				init();
+				kq::run_task(groups(n));
+				loop();
+			});
+
+} // namespace
+
+} // namespace netd::bench
@@ -0,0 +1,86 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of
+ * this software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at
+ * large and to the detriment of our heirs and successors. We intend this
+ * dedication to be an overt act of relinquishment in perpetuity of all present
+ * and future rights to this software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <charconv>
+#include <cstdlib>
+#include <print>
+#include <string_view>
+
+#include <unistd.h>
+
+import bench;
+
+auto usage() -> int
+{
+	std::print(stderr,
+		   "usage: {} [-j] [-b baseline] [-t threshold] [prefix]\n",
+		   getprogname());
+	return 1;
+}
+
+/*
+ * -j writes the results as JSON, which can be saved as a baseline.
+ * -b compares the results with a baseline, and exits with status 2 if any
+ *    benchmark is more than threshold percent (default 10) slower, or
+ *    allocates more.
+ */
+auto main(int argc, char **argv) -> int
+{
+	auto opts = netd::bench::options();
+	int  ch;
+
+	while ((ch = ::getopt(argc, argv, "b:jt:")) != -1) {
+		switch (ch) {
+		case 'b':
+			opts.o_baseline = optarg;
+			break;
+
+		case 'j':
+			opts.o_json = true;
+			break;
+
+		case 't': {
+			auto arg = std::string_view(optarg);
+			auto [ptr, ec] = std::from_chars(
+				arg.data(), arg.data() + arg.size(),
+				opts.o_threshold);
+			if (ec != std::errc() || ptr != arg.data() + arg.size())
+				return usage();
+			break;
+		}
+
+		default:
+			return usage();
+		}
+	}
+
+	argc -= optind;
+	argv += optind;
+
+	if (argc > 1)
+		return usage();
+
+	if (argc == 1)
+		opts.o_prefix = argv[0];
+
+	return netd::bench::run(opts);
+}
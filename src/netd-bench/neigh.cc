@@ -0,0 +1,126 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of
+ * this software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at
+ * large and to the detriment of our heirs and successors. We intend this
+ * dedication to be an overt act of relinquishment in perpetuity of all present
+ * and future rights to this software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * the neighbour cache with the number of neighbours a hypervisor host might
+ * have: updating entries, and listing them with a state filter.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include <netinet/in.h>
+
+#include <netlink/netlink.h>
+#include <netlink/route/neigh.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+import bench;
+import neigh;
+import netlink;
+
+namespace netd::bench {
+
+namespace {
+
+/* the number of neighbours in the table */
+constexpr std::uint32_t nneighs = 50'000;
+
+/* send the table an update for neighbour i, as netlink would */
+auto update(std::uint32_t i, std::uint16_t state) -> void
+{
+	auto addr = std::array<std::uint8_t, 4>{
+		10,
+		static_cast<std::uint8_t>(i >> 16),
+		static_cast<std::uint8_t>(i >> 8),
+		static_cast<std::uint8_t>(i),
+	};
+	auto lladdr = std::array<std::uint8_t, 6>{
+		0x02, 0, 0,
+		static_cast<std::uint8_t>(i >> 16),
+		static_cast<std::uint8_t>(i >> 8),
+		static_cast<std::uint8_t>(i),
+	};
+
+	auto msg = netlink::neigh_data{
+		.ne_family = AF_INET,
+		.ne_ifindex = static_cast<int>(i % 8 + 1),
+		.ne_state = state,
+		.ne_flags = 0,
+		.ne_dst = addr.data(),
+		.ne_lladdr = lladdr.data(),
+		.ne_lladdr_len = lladdr.size(),
+	};
+
+	netlink::evt_newneigh.dispatch(msg);
+}
+
+auto populate() -> bool
+{
+	neigh::init();
+
+	/* one in eight neighbours is stale */
+	for (auto i = std::uint32_t{0}; i < nneighs; ++i)
+		update(i, i % 8 ? NUD_REACHABLE : NUD_STALE);
+
+	return true;
+}
+
+auto const populated = populate();
+
+/* walk the whole table, as a filtered NEIGH_LIST would */
+auto list_stale() -> std::uint64_t
+{
+	auto sum = std::uint64_t{0};
+	auto filt = neigh::filter{.f_ifindex = {}, .f_states = NUD_STALE};
+
+	(void)neigh::visit(filt, 0, [&](neigh::neighbor const &nb) {
+		sum += nb.nb_lladdr.size();
+		return true;
+	});
+
+	return sum;
+}
+
+/* update 1024 existing neighbours spread across the table */
+auto update_some() -> void
+{
+	for (auto i = std::uint32_t{0}; i < 1024; ++i)
+		update(i * 37, NUD_REACHABLE);
+}
+
+auto const registered = add("neigh/update", 1024,
+			    [](std::uint64_t n) {
+				    while (n--)
+					    update_some();
+			    })
+		     && add("neigh/list/stale", nneighs, [](std::uint64_t n) {
+				while (n--)
+					keep(list_stale());
+			});
+
+} // namespace
+
+} // namespace netd::bench
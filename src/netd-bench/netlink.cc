@@ -0,0 +1,386 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of
+ * this software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at
+ * large and to the detriment of our heirs and successors. We intend this
+ * dedication to be an overt act of relinquishment in perpetuity of all present
+ * and future rights to this software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * decoding the netlink messages netd receives most often: link updates, which
+ * carry the interface statistics, and route and neighbour changes.  this only
+ * measures parsing; dispatching the result is covered by the benchmarks for
+ * the subsystems which handle it.
+ *
+ * netlink/ingest/flap measures a link flap storm: every message is decoded
+ * and coalesced, and each turn's worth is dispatched as one batch.
+ *
+ * netlink/storm/* replay a route storm while links flap, and measure one turn
+ * of the event loop which handles a link change.  with a single socket, the
+ * link change shares its turn with a reader's turn worth of route changes;
+ * with a route shard, the storm is replayed into the shard on another thread,
+ * and the turn only holds the link change and one slice of route summaries.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include <net/if.h>
+#include <netinet/in.h>
+
+#include <netlink/netlink.h>
+#include <netlink/route/interface.h>
+#include <netlink/route/route.h>
+#include <netlink/route/neigh.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <stop_token>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+import bench;
+import netd.async;
+import netd.util;
+import netlink;
+
+namespace netd::bench {
+
+namespace {
+
+/*
+ * build a netlink message in a fixed buffer.
+ */
+struct message {
+	alignas(nlmsghdr) std::array<std::byte, 1024> m_buf{};
+
+	template<typename Hdr>
+	explicit message(std::uint16_t type, Hdr const &hdr) noexcept
+	{
+		auto *nlh = this->hdr();
+		nlh->nlmsg_len = NLMSG_LENGTH(sizeof(hdr));
+		nlh->nlmsg_type = type;
+		std::memcpy(NLMSG_DATA(nlh), &hdr, sizeof(hdr));
+	}
+
+	[[nodiscard]] auto hdr() noexcept -> nlmsghdr *
+	{
+		return reinterpret_cast<nlmsghdr *>(m_buf.data());
+	}
+
+	/* append an attribute, and return it so it can be nested into */
+	auto attr(std::uint16_t type, void const *data,
+		  std::size_t len) noexcept -> rtattr *
+	{
+		auto *nlh = hdr();
+		auto *rta = reinterpret_cast<rtattr *>(
+			m_buf.data() + NLMSG_ALIGN(nlh->nlmsg_len));
+
+		rta->rta_type = type;
+		rta->rta_len = static_cast<unsigned short>(RTA_LENGTH(len));
+		if (len > 0)
+			std::memcpy(RTA_DATA(rta), data, len);
+
+		nlh->nlmsg_len = static_cast<std::uint32_t>(
+			NLMSG_ALIGN(nlh->nlmsg_len) + RTA_ALIGN(rta->rta_len));
+		return rta;
+	}
+
+	auto attr(std::uint16_t type, std::string_view str) noexcept -> rtattr *
+	{
+		/* strings are sent with their nul terminator */
+		auto *rta = attr(type, str.data(), str.size() + 1);
+		static_cast<char *>(RTA_DATA(rta))[str.size()] = '\0';
+		return rta;
+	}
+
+	/* close a nested attribute opened with attr(type, nullptr, 0) */
+	auto close(rtattr *nest) noexcept -> void
+	{
+		nest->rta_len = static_cast<unsigned short>(
+			reinterpret_cast<std::byte *>(hdr()) + hdr()->nlmsg_len
+			- reinterpret_cast<std::byte *>(nest));
+	}
+};
+
+/* an RTM_NEWLINK for a vlan interface, as sent on every stats pass */
+auto make_link() -> message
+{
+	auto ifi = ifinfomsg{};
+	ifi.ifi_family = AF_UNSPEC;
+	ifi.ifi_index = 42;
+	ifi.ifi_flags = IFF_UP | IFF_RUNNING;
+
+	auto msg = message(RTM_NEWLINK, ifi);
+
+	auto operstate = std::uint8_t{IF_OPER_UP};
+	auto mtu = std::uint32_t{1500};
+	auto stats = rtnl_link_stats64{};
+	stats.rx_bytes = 123'456'789;
+	stats.tx_bytes = 987'654'321;
+
+	msg.attr(IFLA_IFNAME, "vlan100");
+	msg.attr(IFLA_MTU, &mtu, sizeof(mtu));
+	msg.attr(IFLA_OPERSTATE, &operstate, sizeof(operstate));
+	msg.attr(IFLA_STATS64, &stats, sizeof(stats));
+
+	auto *info = msg.attr(IFLA_LINKINFO, nullptr, 0);
+	msg.attr(IFLA_INFO_KIND, "vlan");
+	msg.close(info);
+
+	return msg;
+}
+
+/* an RTM_NEWROUTE for an IPv4 prefix with a gateway */
+auto make_route() -> message
+{
+	auto rtm = rtmsg{};
+	rtm.rtm_family = AF_INET;
+	rtm.rtm_dst_len = 24;
+	rtm.rtm_table = RT_TABLE_MAIN;
+	rtm.rtm_type = RTN_UNICAST;
+
+	auto msg = message(RTM_NEWROUTE, rtm);
+
+	auto dst = std::array<std::uint8_t, 4>{192, 0, 2, 0};
+	auto gw = std::array<std::uint8_t, 4>{198, 51, 100, 1};
+	auto oif = std::uint32_t{42};
+
+	msg.attr(RTA_DST, dst.data(), dst.size());
+	msg.attr(RTA_GATEWAY, gw.data(), gw.size());
+	msg.attr(RTA_OIF, &oif, sizeof(oif));
+
+	return msg;
+}
+
+/* an RTM_NEWNEIGH for a resolved IPv6 neighbour */
+auto make_neigh() -> message
+{
+	auto ndm = ndmsg{};
+	ndm.ndm_family = AF_INET6;
+	ndm.ndm_ifindex = 42;
+	ndm.ndm_state = NUD_REACHABLE;
+
+	auto msg = message(RTM_NEWNEIGH, ndm);
+
+	auto dst = std::array<std::uint8_t, 16>{0x20, 0x01, 0x0d, 0xb8};
+	auto lladdr = std::array<std::uint8_t, 6>{0x02, 0, 0, 0, 0, 1};
+
+	msg.attr(NDA_DST, dst.data(), dst.size());
+	msg.attr(NDA_LLADDR, lladdr.data(), lladdr.size());
+
+	return msg;
+}
+
+/*
+ * a flap storm: the interfaces the iface benchmarks create as vtnet0 to
+ * vtnet15, each going up and down in turn.
+ */
+constexpr int nflapping = 16;
+
+/* the number of messages the reader takes in one turn */
+constexpr std::uint64_t flap_turn = 1024;
+
+auto make_flap(int ifindex, bool up) -> message
+{
+	auto ifi = ifinfomsg{};
+	ifi.ifi_family = AF_UNSPEC;
+	ifi.ifi_index = ifindex;
+	ifi.ifi_flags = IFF_UP | (up ? IFF_RUNNING : 0);
+
+	auto msg = message(RTM_NEWLINK, ifi);
+	auto name = std::format("vtnet{}", ifindex - 1);
+	auto operstate =
+		static_cast<std::uint8_t>(up ? IF_OPER_UP : IF_OPER_DOWN);
+
+	msg.attr(IFLA_IFNAME, name);
+	msg.attr(IFLA_OPERSTATE, &operstate, sizeof(operstate));
+
+	auto *info = msg.attr(IFLA_LINKINFO, nullptr, 0);
+	msg.attr(IFLA_INFO_KIND, "vtnet");
+	msg.close(info);
+
+	return msg;
+}
+
+auto make_storm() -> std::vector<message>
+{
+	auto msgs = std::vector<message>();
+
+	for (auto i = 0; i < nflapping * 2; ++i)
+		msgs.push_back(make_flap(i % nflapping + 1, i < nflapping));
+
+	return msgs;
+}
+
+auto flap_turns(std::uint64_t n) -> void
+{
+	static auto storm = make_storm();
+
+	while (n--) {
+		for (auto i = std::uint64_t{0}; i < flap_turn; ++i)
+			netlink::ingest(storm[i % storm.size()].hdr());
+		netlink::flush_links();
+	}
+}
+
+/* the number of distinct prefixes in the route storm */
+constexpr std::uint32_t nstorm = 4096;
+
+/* how many route messages the kernel packs into each datagram */
+constexpr std::size_t storm_batch = 32;
+
+/* the messages the reader takes in one turn, as netlink::msgs_per_turn */
+constexpr std::uint64_t reader_turn = 1024;
+
+/* the summaries a shard applies in one turn, as netlink::msgs_per_yield */
+constexpr std::size_t shard_slice = 64;
+
+/* an RTM_NEWROUTE for 10.x.y.0/24, where i is x.y */
+auto make_storm_route(std::uint32_t i) -> message
+{
+	auto rtm = rtmsg{};
+	rtm.rtm_family = AF_INET;
+	rtm.rtm_dst_len = 24;
+	rtm.rtm_table = RT_TABLE_MAIN;
+	rtm.rtm_type = RTN_UNICAST;
+
+	auto msg = message(RTM_NEWROUTE, rtm);
+
+	auto dst = std::array<std::uint8_t, 4>{
+		10, static_cast<std::uint8_t>(i >> 8),
+		static_cast<std::uint8_t>(i), 0};
+	auto gw = std::array<std::uint8_t, 4>{198, 51, 100, 1};
+	auto oif = std::uint32_t{42};
+
+	msg.attr(RTA_DST, dst.data(), dst.size());
+	msg.attr(RTA_GATEWAY, gw.data(), gw.size());
+	msg.attr(RTA_OIF, &oif, sizeof(oif));
+
+	return msg;
+}
+
+auto make_route_storm() -> std::vector<message>
+{
+	auto msgs = std::vector<message>();
+
+	for (auto i = std::uint32_t{0}; i < nstorm; ++i)
+		msgs.push_back(make_storm_route(i));
+
+	return msgs;
+}
+
+/* the storm as the kernel would send it, storm_batch messages a datagram */
+auto record_storm(std::vector<message> &msgs)
+	-> std::vector<std::vector<std::byte>>
+{
+	auto datagrams = std::vector<std::vector<std::byte>>();
+
+	for (auto i = std::size_t{0}; i < msgs.size(); ++i) {
+		if (i % storm_batch == 0)
+			datagrams.emplace_back();
+
+		auto *hdr = msgs[i].hdr();
+		auto *bytes = reinterpret_cast<std::byte const *>(hdr);
+		datagrams.back().insert(datagrams.back().end(), bytes,
+					bytes + NLMSG_ALIGN(hdr->nlmsg_len));
+	}
+
+	return datagrams;
+}
+
+auto storm_single(std::uint64_t n) -> void
+{
+	static auto storm = make_route_storm();
+	static auto flaps = std::array{make_flap(1, false), make_flap(1, true)};
+	auto	    next = std::size_t{0};
+
+	while (n--) {
+		netlink::ingest(flaps[n % 2].hdr());
+
+		for (auto i = std::uint64_t{1}; i < reader_turn; ++i)
+			netlink::ingest(storm[next++ % storm.size()].hdr());
+
+		netlink::flush_links();
+	}
+}
+
+auto storm_sharded(std::uint64_t n) -> void
+{
+	static auto storm = make_route_storm();
+	static auto datagrams = record_storm(storm);
+	static auto flaps = std::array{make_flap(1, false), make_flap(1, true)};
+
+	int fds[2];
+	if (::socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, fds) == -1)
+		panic("socketpair: {}", error::strerror());
+
+	auto tx = fd(fds[1]);
+	auto shard = netlink::route_shard(fd(fds[0]));
+
+	/* declared last, so it's stopped before the shard */
+	auto replay = std::jthread([&](std::stop_token stop) {
+		for (auto i = std::size_t{0}; !stop.stop_requested(); ++i) {
+			auto &dg = datagrams[i % datagrams.size()];
+			(void)::send(tx.get(), dg.data(), dg.size(), 0);
+		}
+	});
+
+	while (n--) {
+		netlink::ingest(flaps[n % 2].hdr());
+		netlink::flush_links();
+		keep(shard.apply(shard_slice));
+	}
+}
+
+auto link_msg = make_link();
+auto route_msg = make_route();
+auto neigh_msg = make_neigh();
+
+auto const registered =
+	add("netlink/decode/link", 1,
+	    [](std::uint64_t n) {
+		    auto data = netlink::newlink_data();
+		    auto stats = rtnl_link_stats64();
+		    while (n--)
+			    keep(netlink::parse_link(link_msg.hdr(), data,
+						     stats));
+	    })
+	&& add("netlink/ingest/flap", flap_turn, flap_turns)
+	&& add("netlink/storm/single", 1, storm_single)
+	&& add("netlink/storm/sharded", 1, storm_sharded)
+	&& add("netlink/decode/route", 1,
+	       [](std::uint64_t n) {
+		       auto data = netlink::route_data();
+		       while (n--)
+			       keep(netlink::parse_route(route_msg.hdr(),
+							 data));
+	       })
+	&& add("netlink/decode/neigh", 1, [](std::uint64_t n) {
+		       auto data = netlink::neigh_data();
+		       while (n--)
+			       keep(netlink::parse_neigh(neigh_msg.hdr(),
+							 data));
+	       });
+
+} // namespace
+
+} // namespace netd::bench
@@ -0,0 +1,179 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of
+ * this software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at
+ * large and to the detriment of our heirs and successors. We intend this
+ * dedication to be an overt act of relinquishment in perpetuity of all present
+ * and future rights to this software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * the cost of building and parsing an INTF_LIST reply with netd::nvl, using
+ * both the copying and the allocation-light parts of the API.
+ */
+
+#include <array>
+#include <cstdint>
+#include <format>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+import bench;
+import netd.nvl;
+import netd.proto;
+import netd.util;
+
+namespace netd::bench {
+
+namespace {
+
+/* about as many interfaces as fit in a single message */
+constexpr std::size_t nintfs = 16;
+
+auto make_names() -> std::vector<std::string>
+{
+	auto names = std::vector<std::string>();
+
+	for (std::size_t i = 0; i < nintfs; ++i)
+		names.push_back(std::format("vtnet{}", i));
+
+	return names;
+}
+
+auto const names = make_names();
+
+/*
+ * build with append_nvlist_array(), which copies each interface, and pack into
+ * a new vector.
+ */
+auto build_copy() -> std::vector<std::byte>
+{
+	auto resp = nvl();
+
+	for (auto &&name: names) {
+		auto nvint = nvl();
+		nvint.add_string(proto::cp_iface_name, name);
+		nvint.add_number(proto::cp_iface_rxrate, 1000);
+		nvint.add_number(proto::cp_iface_txrate, 2000);
+		nvint.add_number(proto::cp_iface_oper, proto::cv_iface_oper_up);
+		nvint.add_number(proto::cp_iface_admin,
+				 proto::cv_iface_admin_up);
+		resp.append_nvlist_array(proto::cp_iface, nvint);
+	}
+
+	return *resp.pack();
+}
+
+/*
+ * build with move_nvlist_array(), and pack into an existing buffer.
+ */
+auto build_move(std::span<std::byte> buf) -> std::size_t
+{
+	auto intfs = std::vector<nvl>();
+	intfs.reserve(names.size());
+
+	for (auto &&name: names) {
+		auto &nvint = intfs.emplace_back();
+		nvint.add_string(proto::cp_iface_name, name);
+		nvint.add_number(proto::cp_iface_rxrate, 1000);
+		nvint.add_number(proto::cp_iface_txrate, 2000);
+		nvint.add_number(proto::cp_iface_oper, proto::cv_iface_oper_up);
+		nvint.add_number(proto::cp_iface_admin,
+				 proto::cv_iface_admin_up);
+	}
+
+	auto resp = nvl();
+	resp.move_nvlist_array(proto::cp_iface, intfs);
+	return *resp.pack_into(buf);
+}
+
+/*
+ * parse the reply.  Key is either std::string_view, which has to be copied
+ * for every lookup, or cstring_view, which doesn't.
+ */
+template<typename Key>
+auto parse(std::vector<std::byte> const &msg) -> std::uint64_t
+{
+	auto const k_iface = Key(proto::cp_iface);
+	auto const k_name = Key(proto::cp_iface_name);
+	auto const k_admin = Key(proto::cp_iface_admin);
+	auto const k_oper = Key(proto::cp_iface_oper);
+	auto const k_rxrate = Key(proto::cp_iface_rxrate);
+	auto const k_txrate = Key(proto::cp_iface_txrate);
+
+	auto sum = std::uint64_t{0};
+	auto resp = nvl::unpack(msg);
+
+	for (auto &&intf: resp->get_nvlist_array(k_iface))
+		sum += intf.get_string(k_name).size()
+		     + intf.get_number(k_admin) + intf.get_number(k_oper)
+		     + intf.get_number(k_rxrate) + intf.get_number(k_txrate);
+
+	return sum;
+}
+
+/*
+ * parse the reply with its schema.
+ */
+auto parse_schema(std::vector<std::byte> const &msg) -> std::uint64_t
+{
+	auto sum = std::uint64_t{0};
+	auto resp = nvl::unpack(msg);
+	auto reply = schema::decode(proto::intf_list_reply_schema, *resp);
+
+	for (auto &&intf: reply->il_interfaces)
+		sum += intf.if_name.size() + intf.if_admin.value_or(0)
+		     + intf.if_oper.value_or(0) + intf.if_rxrate.value_or(0)
+		     + intf.if_txrate.value_or(0);
+
+	return sum;
+}
+
+auto const msg = build_copy();
+
+auto const registered =
+	add("nvl/intf_list/build/copy", nintfs,
+	    [](std::uint64_t n) {
+		    while (n--)
+			    keep(build_copy());
+	    })
+	&& add("nvl/intf_list/build/move", nintfs,
+	       [](std::uint64_t n) {
+		       auto buf = std::array<std::byte, proto::max_msg_size>();
+		       while (n--)
+			       keep(build_move(buf));
+	       })
+	&& add("nvl/intf_list/parse/string_view", nintfs,
+	       [](std::uint64_t n) {
+		       while (n--)
+			       keep(parse<std::string_view>(msg));
+	       })
+	&& add("nvl/intf_list/parse/cstring_view", nintfs,
+	       [](std::uint64_t n) {
+		       while (n--)
+			       keep(parse<cstring_view>(msg));
+	       })
+	&& add("nvl/intf_list/parse/schema", nintfs,
+	       [](std::uint64_t n) {
+		       while (n--)
+			       keep(parse_schema(msg));
+	       });
+
+} // namespace
+
+} // namespace netd::bench
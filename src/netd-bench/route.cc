@@ -0,0 +1,221 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of
+ * this software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at
+ * large and to the detriment of our heirs and successors. We intend this
+ * dedication to be an overt act of relinquishment in perpetuity of all present
+ * and future rights to this software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * the routing table mirror loaded with a million IPv4 prefixes, about the
+ * size of a full Internet table, and a smaller IPv6 table.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include <netinet/in.h>
+
+#include <netlink/netlink.h>
+#include <netlink/route/route.h>
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <print>
+#include <random>
+#include <vector>
+
+import bench;
+import netlink;
+import route;
+
+namespace netd::bench {
+
+namespace {
+
+/* the number of prefixes in each table */
+constexpr std::size_t ninet = 1'000'000;
+constexpr std::size_t ninet6 = 200'000;
+
+/* the number of distinct next hops */
+constexpr std::uint32_t ngateways = 16;
+
+/* the number of lookups per iteration */
+constexpr std::size_t nlookups = 1024;
+
+struct prefix {
+	std::array<std::uint8_t, 16> p_addr;
+	unsigned		     p_plen;
+};
+
+/*
+ * generate random prefixes.  as in a real table, most IPv4 prefixes are /24s
+ * and most IPv6 prefixes are /48s, with the rest spread over shorter lengths.
+ */
+auto make_prefixes(int family, std::size_t n) -> std::vector<prefix>
+{
+	auto rng = std::mt19937(42);
+	auto ret = std::vector<prefix>(n);
+
+	for (auto &&p: ret) {
+		auto r = rng() % 100;
+
+		if (family == AF_INET)
+			p.p_plen = r < 60 ? 24 : 16 + r % 8;
+		else
+			p.p_plen = r < 50 ? 48 : 28 + r % 20;
+
+		for (auto &&byte: p.p_addr)
+			byte = static_cast<std::uint8_t>(rng());
+	}
+
+	return ret;
+}
+
+auto dispatch(int family, prefix const &p, std::uint32_t i) -> void
+{
+	auto gw = std::array<std::uint8_t, 16>{};
+	gw[0] = 10;
+	gw[3] = static_cast<std::uint8_t>(i % ngateways + 1);
+	if (family == AF_INET6) {
+		gw[0] = 0xfe;
+		gw[1] = 0x80;
+		gw[15] = gw[3];
+		gw[3] = 0;
+	}
+
+	auto msg = netlink::route_data{
+		.rt_family = family,
+		.rt_plen = p.p_plen,
+		.rt_type = RTN_UNICAST,
+		.rt_table = RT_TABLE_MAIN,
+		.rt_oifindex = static_cast<int>(i % 4 + 1),
+		.rt_dst = p.p_addr.data(),
+		.rt_gateway = gw.data(),
+	};
+
+	netlink::evt_newroute.dispatch(msg);
+}
+
+auto const inet_prefixes = make_prefixes(AF_INET, ninet);
+auto const inet6_prefixes = make_prefixes(AF_INET6, ninet6);
+
+/*
+ * load the tables by sending route::init() the same events netlink would,
+ * and report how long it took and how much memory the tables use.
+ */
+auto populate() -> bool
+{
+	route::init();
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (auto i = std::uint32_t{0}; i < ninet; ++i)
+		dispatch(AF_INET, inet_prefixes[i], i);
+	for (auto i = std::uint32_t{0}; i < ninet6; ++i)
+		dispatch(AF_INET6, inet6_prefixes[i], i);
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - start);
+
+	auto stats = route::get_stats();
+	std::println(stderr,
+		     "route: loaded {} IPv4 and {} IPv6 routes in {}; "
+		     "{} next hops, rib {} KiB, fib {} KiB",
+		     stats.st_routes_inet, stats.st_routes_inet6, elapsed,
+		     stats.st_nexthops, stats.st_rib_bytes / 1024,
+		     stats.st_fib_bytes / 1024);
+	return true;
+}
+
+auto const populated = populate();
+
+/* look up nlookups addresses within the loaded prefixes */
+auto lookup_inet() -> std::uint64_t
+{
+	auto sum = std::uint64_t{0};
+
+	for (auto i = std::size_t{0}; i < nlookups; ++i) {
+		auto const &p = inet_prefixes[i * (ninet / nlookups)];
+		auto addr = in_addr{};
+		std::memcpy(&addr, p.p_addr.data(), sizeof(addr));
+
+		if (auto rv = route::lookup(addr); rv)
+			sum += rv->rv_plen;
+	}
+
+	return sum;
+}
+
+auto lookup_inet6() -> std::uint64_t
+{
+	auto sum = std::uint64_t{0};
+
+	for (auto i = std::size_t{0}; i < nlookups; ++i) {
+		auto const &p = inet6_prefixes[i * (ninet6 / nlookups)];
+		auto addr = std::bit_cast<in6_addr>(p.p_addr);
+
+		if (auto rv = route::lookup(addr); rv)
+			sum += rv->rv_plen;
+	}
+
+	return sum;
+}
+
+/* add and remove a /25, which splits a /24 in the DIR-24-8 table */
+auto churn() -> std::uint64_t
+{
+	auto p = inet_prefixes[0];
+	p.p_plen = 25;
+
+	auto msg = netlink::route_data{
+		.rt_family = AF_INET,
+		.rt_plen = p.p_plen,
+		.rt_type = RTN_BLACKHOLE,
+		.rt_table = RT_TABLE_MAIN,
+		.rt_oifindex = 0,
+		.rt_dst = p.p_addr.data(),
+		.rt_gateway = nullptr,
+	};
+
+	netlink::evt_newroute.dispatch(msg);
+	netlink::evt_delroute.dispatch(msg);
+	return route::get_stats().st_routes_inet;
+}
+
+auto const registered = add("route/inet/lookup", nlookups,
+			    [](std::uint64_t n) {
+				    while (n--)
+					    keep(lookup_inet());
+			    })
+		     && add("route/inet6/lookup", nlookups,
+			    [](std::uint64_t n) {
+				    while (n--)
+					    keep(lookup_inet6());
+			    })
+		     && add("route/inet/churn", 2, [](std::uint64_t n) {
+				while (n--)
+					keep(churn());
+			});
+
+} // namespace
+
+} // namespace netd::bench
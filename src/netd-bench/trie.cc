@@ -0,0 +1,237 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of
+ * this software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at
+ * large and to the detriment of our heirs and successors. We intend this
+ * dedication to be an overt act of relinquishment in perpetuity of all present
+ * and future rights to this software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * prefix_trie lookups with a million IPv4 and IPv6 addresses, which is the
+ * size of address index a large router might have.  trie/inet/page also
+ * checks that paging through nested prefixes returns each one once.
+ */
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+import bench;
+import netd.util;
+
+namespace netd::bench {
+
+namespace {
+
+/* the number of addresses in each trie */
+constexpr std::size_t naddrs = 1'000'000;
+
+/* the number of lookups per iteration */
+constexpr std::size_t nlookups = 1024;
+
+using inet_trie = prefix_trie<4, std::uint32_t>;
+using inet6_trie = prefix_trie<16, std::uint32_t>;
+
+/* generate random keys; a fixed seed keeps runs comparable */
+template<typename Key>
+auto make_keys(std::size_t n) -> std::vector<Key>
+{
+	auto rng = std::mt19937(42);
+	auto keys = std::vector<Key>(n);
+
+	for (auto &&key: keys)
+		for (auto &&byte: key)
+			byte = static_cast<std::uint8_t>(rng());
+
+	return keys;
+}
+
+template<typename Trie>
+auto make_trie(std::vector<typename Trie::key_type> const &keys) -> Trie
+{
+	auto trie = Trie();
+	auto i = std::uint32_t{0};
+
+	for (auto &&key: keys)
+		(void)trie.insert(key, Trie::max_plen, i++);
+
+	return trie;
+}
+
+auto const inet_keys = make_keys<inet_trie::key_type>(naddrs);
+auto const inet6_keys = make_keys<inet6_trie::key_type>(naddrs);
+auto	   inet = make_trie<inet_trie>(inet_keys);
+auto	   inet6 = make_trie<inet6_trie>(inet6_keys);
+
+/* look up nlookups keys, spread across the whole table */
+template<typename Trie>
+auto find(Trie &trie, std::vector<typename Trie::key_type> const &keys)
+	-> std::uint64_t
+{
+	auto sum = std::uint64_t{0};
+
+	for (auto i = std::size_t{0}; i < nlookups; ++i)
+		if (auto *v = trie.find(keys[i * (naddrs / nlookups)],
+					Trie::max_plen);
+		    v != nullptr)
+			sum += *v;
+
+	return sum;
+}
+
+template<typename Trie>
+auto longest_match(Trie &trie, std::vector<typename Trie::key_type> const &keys)
+	-> std::uint64_t
+{
+	auto sum = std::uint64_t{0};
+
+	for (auto i = std::size_t{0}; i < nlookups; ++i) {
+		/* flip the last bit so most lookups miss the exact entry */
+		auto key = keys[i * (naddrs / nlookups)];
+		key.back() ^= 1u;
+
+		if (auto m = trie.longest_match(key); m)
+			sum += m->m_plen;
+	}
+
+	return sum;
+}
+
+/* enumerate the addresses in a /16, about 15 of them */
+auto covered16() -> std::uint64_t
+{
+	auto sum = std::uint64_t{0};
+
+	inet.visit_covered(inet_keys[0], 16,
+			   [&](auto const &, unsigned, std::uint32_t v) {
+				   sum += v;
+			   });
+
+	return sum;
+}
+
+/*
+ * a default route, a chain of nested prefixes and some siblings, which is the
+ * shape of table where a ROUTE_LIST cursor falls inside covering prefixes.
+ */
+struct prefix {
+	inet_trie::key_type p_key;
+	unsigned	    p_plen;
+};
+
+constexpr auto nested_prefixes = std::array<prefix, 9>{{
+	{{0, 0, 0, 0}, 0},
+	{{10, 0, 0, 0}, 8},
+	{{10, 1, 0, 0}, 16},
+	{{10, 1, 1, 0}, 24},
+	{{10, 1, 1, 128}, 25},
+	{{10, 1, 2, 0}, 24},
+	{{10, 2, 0, 0}, 16},
+	{{11, 0, 0, 0}, 8},
+	{{192, 168, 0, 0}, 16},
+}};
+
+auto const nested = [] {
+	auto trie = inet_trie();
+	auto i = std::uint32_t{0};
+
+	for (auto &&p: nested_prefixes)
+		(void)trie.insert(p.p_key, p.p_plen, i++);
+
+	return trie;
+}();
+
+/*
+ * walk the nested table two prefixes at a time, resuming after the last
+ * prefix of each page as netctl does, and check nothing is returned twice.
+ */
+auto page_nested() -> std::uint64_t
+{
+	constexpr auto limit = 2u;
+	auto const     all = inet_trie::key_type{};
+	auto	       seen = std::array<unsigned, nested_prefixes.size()>{};
+	auto	       last = std::optional<prefix>();
+
+	/* a correct walk needs size / limit + 1 pages; don't loop forever */
+	for (auto page = 0u; page <= nested_prefixes.size(); ++page) {
+		auto n = 0u;
+		auto fn = [&](auto const &key, unsigned plen, std::uint32_t v) {
+			++seen[v];
+			last = prefix{key, plen};
+			return ++n < limit;
+		};
+
+		if (last)
+			nested.visit_covered_after(all, 0, last->p_key,
+						   last->p_plen, fn);
+		else
+			nested.visit_covered(all, 0, fn);
+
+		if (n < limit)
+			break;
+	}
+
+	for (auto i = std::size_t{0}; i < seen.size(); ++i)
+		if (seen[i] != 1)
+			panic("trie/inet/page: prefix {} returned {} times", i,
+			      seen[i]);
+
+	return seen.size();
+}
+
+auto const registered =
+	add("trie/inet/build", naddrs,
+	    [](std::uint64_t n) {
+		    while (n--)
+			    keep(make_trie<inet_trie>(inet_keys).size());
+	    })
+	&& add("trie/inet/find", nlookups,
+	       [](std::uint64_t n) {
+		       while (n--)
+			       keep(find(inet, inet_keys));
+	       })
+	&& add("trie/inet/longest_match", nlookups,
+	       [](std::uint64_t n) {
+		       while (n--)
+			       keep(longest_match(inet, inet_keys));
+	       })
+	&& add("trie/inet/covered/16", 1,
+	       [](std::uint64_t n) {
+		       while (n--)
+			       keep(covered16());
+	       })
+	&& add("trie/inet/page", nested_prefixes.size(),
+	       [](std::uint64_t n) {
+		       while (n--)
+			       keep(page_nested());
+	       })
+	&& add("trie/inet6/find", nlookups,
+	       [](std::uint64_t n) {
+		       while (n--)
+			       keep(find(inet6, inet6_keys));
+	       })
+	&& add("trie/inet6/longest_match", nlookups,
+	       [](std::uint64_t n) {
+		       while (n--)
+			       keep(longest_match(inet6, inet6_keys));
+	       });
+
+} // namespace
+
+} // namespace netd::bench
@@ -0,0 +1,183 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of
+ * this software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at
+ * large and to the detriment of our heirs and successors. We intend this
+ * dedication to be an overt act of relinquishment in perpetuity of all present
+ * and future rights to this software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * the building blocks every subsystem uses: isam containers and their
+ * indices, event dispatch and rate calculation.
+ */
+
+#include <cstdint>
+#include <format>
+#include <string>
+#include <vector>
+
+import bench;
+import netd.util;
+
+namespace netd::bench {
+
+namespace {
+
+/*
+ * isam: an interface-like object, indexed by id and name, as iface does.
+ */
+struct object {
+	std::uint64_t o_id;
+	std::string   o_name;
+};
+
+/* the number of objects in the lookup table */
+constexpr std::uint64_t nobjects = 10'000;
+
+/* the number of objects inserted and erased per iteration */
+constexpr std::uint64_t nchurn = 1024;
+
+struct table {
+	isam::isam<object> t_objects;
+	isam::index<object, std::uint64_t> t_by_id{
+		t_objects, [](object const &o) { return o.o_id; }};
+	isam::index<object, std::string> t_by_name{
+		t_objects, [](object const &o) { return o.o_name; }};
+	isam::generation<object> t_gen{t_objects};
+};
+
+auto make_names(std::uint64_t n) -> std::vector<std::string>
+{
+	auto names = std::vector<std::string>();
+
+	for (auto i = std::uint64_t{0}; i < n; ++i)
+		names.push_back(std::format("vtnet{}", i));
+
+	return names;
+}
+
+auto const names = make_names(nobjects);
+
+/* a table holding nobjects objects, for lookups */
+auto lookup_table() -> table &
+{
+	static auto *tbl = [] {
+		auto *ret = new table;
+		for (auto i = std::uint64_t{0}; i < nobjects; ++i)
+			ret->t_objects.insert(object{i, names[i]});
+		return ret;
+	}();
+
+	return *tbl;
+}
+
+/* insert nchurn objects into an empty table, then erase them */
+auto churn(table &tbl) -> void
+{
+	for (auto i = std::uint64_t{0}; i < nchurn; ++i)
+		tbl.t_objects.insert(object{i, names[i]});
+
+	while (tbl.t_objects.begin() != tbl.t_objects.end())
+		tbl.t_objects.erase(tbl.t_objects.begin());
+}
+
+auto lookup_id(table &tbl) -> std::uint64_t
+{
+	auto sum = std::uint64_t{0};
+
+	for (auto i = std::uint64_t{0}; i < nobjects; ++i)
+		sum += tbl.t_by_id.find(i)->second->o_name.size();
+
+	return sum;
+}
+
+auto lookup_name(table &tbl) -> std::uint64_t
+{
+	auto sum = std::uint64_t{0};
+
+	for (auto &&name: names)
+		sum += tbl.t_by_name.find(name)->second->o_id;
+
+	return sum;
+}
+
+/*
+ * event: dispatch to a number of subscribers, each doing trivial work.
+ */
+auto dispatch(std::uint64_t n, std::size_t nsubs) -> void
+{
+	auto evt = event::event<std::uint64_t>();
+	auto subs = std::vector<event::sub>();
+	auto sum = std::uint64_t{0};
+
+	for (auto i = std::size_t{0}; i < nsubs; ++i)
+		subs.push_back(event::sub(
+			evt, [&](std::uint64_t v) noexcept { sum += v; }));
+
+	while (n--)
+		evt.dispatch(n);
+
+	keep(sum);
+}
+
+/*
+ * rate: as used for the interface counters, which are updated on every stats
+ * pass and read by every INTF_LIST.
+ */
+using counter_rate = rate<std::uint64_t, 3>;
+
+auto const registered =
+	add("isam/insert+erase", nchurn,
+	    [](std::uint64_t n) {
+		    auto tbl = table();
+		    while (n--)
+			    churn(tbl);
+	    })
+	&& add("isam/lookup/hash", nobjects,
+	       [](std::uint64_t n) {
+		       auto &tbl = lookup_table();
+		       while (n--)
+			       keep(lookup_id(tbl));
+	       })
+	&& add("isam/lookup/string", nobjects,
+	       [](std::uint64_t n) {
+		       auto &tbl = lookup_table();
+		       while (n--)
+			       keep(lookup_name(tbl));
+	       })
+	&& add("event/dispatch/1", 1,
+	       [](std::uint64_t n) { dispatch(n, 1); })
+	&& add("event/dispatch/8", 8,
+	       [](std::uint64_t n) { dispatch(n, 8); })
+	&& add("rate/update", 1,
+	       [](std::uint64_t n) {
+		       auto r = counter_rate();
+		       while (n--)
+			       r.update(n);
+		       keep(r.last());
+	       })
+	&& add("rate/get", 1, [](std::uint64_t n) {
+		       auto r = counter_rate();
+		       for (auto i = std::uint64_t{0}; i < 3; ++i)
+			       r.update(i * 1000);
+		       while (n--)
+			       keep(r.get());
+	       });
+
+} // namespace
+
+} // namespace netd::bench
@@ -0,0 +1,164 @@
+/*
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+ * this software, either in source code form or as a compiled binary, for any
+ * purpose, commercial or non-commercial, and by any means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors of
+ * this software dedicate any and all copyright interest in the software to the
+ * public domain. We make this dedication for the benefit of the public at
+ * large and to the detriment of our heirs and successors. We intend this
+ * dedication to be an overt act of relinquishment in perpetuity of all present
+ * and future rights to this software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * compare the nvlist and binary wire encodings of an INTF_LIST reply.
+ */
+
+#include <cstdint>
+#include <format>
+#include <string>
+#include <vector>
+
+import bench;
+import netd.nvl;
+import netd.proto;
+
+namespace netd::bench {
+
+namespace {
+
+/* the number of interfaces in each reply */
+constexpr std::size_t nintfs = 10'000;
+
+struct intfdata {
+	std::string   name;
+	std::uint32_t index;
+	std::uint32_t flags;
+	std::uint64_t admin;
+	std::uint64_t oper;
+	std::uint64_t rxrate;
+	std::uint64_t txrate;
+};
+
+auto make_intfs() -> std::vector<intfdata>
+{
+	auto intfs = std::vector<intfdata>();
+	intfs.reserve(nintfs);
+
+	for (std::size_t i = 0; i < nintfs; ++i)
+		intfs.push_back({
+			.name = std::format("vtnet{}", i),
+			.index = static_cast<std::uint32_t>(i + 1),
+			.flags = 0x8843,
+			.admin = proto::cv_iface_admin_up,
+			.oper = proto::cv_iface_oper_up,
+			.rxrate = i * 1000,
+			.txrate = i * 2000,
+		});
+
+	return intfs;
+}
+
+auto const intfs = make_intfs();
+
+auto encode_nvl() -> std::vector<std::byte>
+{
+	auto resp = nvl();
+
+	for (auto &&intf: intfs) {
+		auto nvint = nvl();
+		nvint.add_string(proto::cp_iface_name, intf.name);
+		nvint.add_number(proto::cp_iface_rxrate, intf.rxrate);
+		nvint.add_number(proto::cp_iface_txrate, intf.txrate);
+		nvint.add_number(proto::cp_iface_oper, intf.oper);
+		nvint.add_number(proto::cp_iface_admin, intf.admin);
+		resp.append_nvlist_array(proto::cp_iface, nvint);
+	}
+
+	return *resp.pack();
+}
+
+auto encode_wire() -> std::vector<std::byte>
+{
+	auto msg = proto::wire::builder<proto::wire::interface>(intfs.size());
+
+	for (auto &&intf: intfs) {
+		auto &rec = msg.add();
+		rec.if_index = intf.index;
+		rec.if_flags = intf.flags;
+		rec.if_admin = static_cast<std::uint8_t>(intf.admin);
+		rec.if_oper = static_cast<std::uint8_t>(intf.oper);
+		rec.if_rxrate = intf.rxrate;
+		rec.if_txrate = intf.txrate;
+		rec.set_name(intf.name);
+	}
+
+	return std::move(msg).finish();
+}
+
+/* decoding reads every field, as netctl does */
+
+auto decode_nvl(std::vector<std::byte> const &msg) -> std::uint64_t
+{
+	auto sum = std::uint64_t{0};
+	auto resp = nvl::unpack(msg);
+
+	for (auto &&intf: resp->get_nvlist_array(proto::cp_iface))
+		sum += intf.get_string(proto::cp_iface_name).size()
+		     + intf.get_number(proto::cp_iface_admin)
+		     + intf.get_number(proto::cp_iface_oper)
+		     + intf.get_number(proto::cp_iface_rxrate)
+		     + intf.get_number(proto::cp_iface_txrate);
+
+	return sum;
+}
+
+auto decode_wire(std::vector<std::byte> const &msg) -> std::uint64_t
+{
+	auto sum = std::uint64_t{0};
+	auto resp = proto::wire::parse<proto::wire::interface>(msg);
+
+	for (auto &&intf: *resp)
+		sum += intf.name().size() + intf.if_admin + intf.if_oper
+		     + intf.if_rxrate + intf.if_txrate;
+
+	return sum;
+}
+
+auto const nvl_msg = encode_nvl();
+auto const wire_msg = encode_wire();
+
+auto const registered = add("wire/encode/nvlist", nintfs,
+			    [](std::uint64_t n) {
+				    while (n--)
+					    keep(encode_nvl());
+			    })
+		     && add("wire/encode/binary", nintfs,
+			    [](std::uint64_t n) {
+				    while (n--)
+					    keep(encode_wire());
+			    })
+		     && add("wire/decode/nvlist", nintfs,
+			    [](std::uint64_t n) {
+				    while (n--)
+					    keep(decode_nvl(nvl_msg));
+			    })
+		     && add("wire/decode/binary", nintfs,
+			    [](std::uint64_t n) {
+				    while (n--)
+					    keep(decode_wire(wire_msg));
+			    });
+
+} // namespace
+
+} // namespace netd::bench
@@ -22,38 +22,915 @@
 
 module;
 
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uuid.h>
+
+#include <net/if.h>
+// clang-format off
+#include <netinet/in.h>
+#include <netinet/if_ether.h>
+// clang-format on
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <expected>
+#include <new>
+#include <span>
+#include <string>
+#include <string_view>
 #include <system_error>
+#include <utility>
+#include <variant>
+#include <vector>
 
 #include "generator.hh"
 
 module db;
 
+import iface;
+import log;
+import netd.async;
 import netd.network;
-import netd.nvl;
+import netd.proto;
 import netd.util;
 
 namespace netd::db {
 
-auto save() noexcept -> std::expected<void, std::error_code>
+/*
+ * the on-disk formats.  the files are only ever read by the host which wrote
+ * them, so they use native byte order.
+ */
+
+constexpr std::uint32_t journal_magic = 0x4e444a52;  /* "NDJR" */
+constexpr std::uint32_t snapshot_magic = 0x4e44534e; /* "NDSN" */
+constexpr std::uint32_t snapshot_version = 1;
+constexpr std::uint32_t warm_magic = 0x4e44574d; /* "NDWM" */
+constexpr std::uint32_t warm_version = 1;
+
+constexpr char const *journal_name = "journal";
+constexpr char const *snapshot_name = "snapshot";
+constexpr char const *snapshot_tmpname = "snapshot.new";
+constexpr char const *warm_name = "interfaces";
+constexpr char const *warm_tmpname = "interfaces.new";
+
+/* journal record types */
+enum struct rectype : std::uint8_t {
+	create = 1, /* uuid, then the name */
+	remove = 2, /* uuid */
+	txn = 3,    /* txn_entry, then the name; repeated */
+};
+
+/*
+ * a journal record is a header followed by rh_length bytes of payload.  the
+ * checksum covers the header (with rh_crc set to 0) and the payload, so a
+ * record torn by a crash is detected and discarded.
+ */
+struct record_header {
+	std::uint32_t rh_magic;
+	std::uint32_t rh_length;
+	std::uint32_t rh_crc;
+	rectype	      rh_type;
+	std::uint8_t  rh_pad[3];
+};
+
+/*
+ * one operation in a txn record, which is either a create or a remove.  a
+ * txn record is replayed entirely or not at all.
+ */
+struct txn_entry {
+	rectype	     te_type;
+	std::uint8_t te_namelen;
+	std::uint8_t te_pad[2];
+	uuid	     te_id;
+};
+
+/* the largest payload we write */
+constexpr std::size_t max_payload = std::max(
+	sizeof(uuid) + proto::cn_maxnetnam,
+	proto::txn_max_ops * (sizeof(txn_entry) + proto::cn_maxnetnam));
+
+/*
+ * a snapshot is a header followed by sh_count fixed-size entries, so it can
+ * be used in place once it's mapped.  the checksum covers the entries.
+ */
+struct snapshot_header {
+	std::uint32_t sh_magic;
+	std::uint32_t sh_version;
+	std::uint32_t sh_count;
+	std::uint32_t sh_crc;
+};
+
+struct snapshot_network {
+	uuid	     sn_id;
+	std::uint8_t sn_namelen;
+	char	     sn_name[proto::cn_maxnetnam];
+	std::uint8_t sn_pad[3];
+};
+
+/*
+ * the warm-start image has the same header as a snapshot, followed by
+ * sh_count interfaces, each followed by wi_naddrs addresses.  the strings are
+ * NUL-padded, but not NUL-terminated if they fill the field.
+ */
+struct warm_interface {
+	std::int32_t  wi_index;
+	std::uint32_t wi_flags;
+	std::uint8_t  wi_operstate;
+	std::uint8_t  wi_naddrs;
+	std::uint8_t  wi_pad[2];
+	char	      wi_name[IFNAMSIZ];
+	char	      wi_kind[IFNAMSIZ];
+};
+
+struct warm_address {
+	std::uint8_t wa_family;
+	std::uint8_t wa_plen;
+	std::uint8_t wa_pad[2];
+	std::uint8_t wa_addr[16];
+};
+
+/*
+ * the open database.
+ */
+
+fd		       db_dir;
+fd		       db_journal;
+std::vector<std::byte> db_pending;	/* records not yet written */
+std::uint64_t	       db_appended = 0; /* the last record added */
+std::uint64_t	       db_durable = 0;	/* the last record on disk */
+std::error_code	       db_error;	/* set if the journal failed */
+bool		       db_replaying = false;
+bool		       db_flush_scheduled = false;
+bool		       db_recovering = false;
+stats		       db_stats{};
+
+/* iface::change_count() when the warm-start image was last written */
+std::uint64_t db_warm_changes = 0;
+bool	      db_warm_writer = false;
+
+/* coroutines waiting in commit() for a record to reach the disk */
+std::vector<std::pair<std::uint64_t, std::coroutine_handle<>>> db_waiters;
+
+event::sub net_created_sub;
+event::sub net_removed_sub;
+event::sub txn_applied_sub;
+event::sub reconciled_sub;
+
+template<typename T>
+auto as_bytes(T const &obj) noexcept -> std::span<std::byte const>
+{
+	return std::as_bytes(std::span(&obj, 1));
+}
+
+auto write_all(int fdesc, std::span<std::byte const> data) noexcept
+	-> std::expected<void, std::error_code>
+{
+	while (!data.empty()) {
+		auto n = ::write(fdesc, data.data(), data.size());
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+			return std::unexpected(error::from_errno());
+		}
+		data = data.subspan(static_cast<std::size_t>(n));
+	}
+
+	return {};
+}
+
+/*
+ * resume any commit() callers whose records are now on disk.  if the journal
+ * failed, they wait for the snapshot which replaces it.
+ */
+auto wake_waiters() noexcept -> void
 {
-	nvl state;
+	/* a resumed caller might commit() again, so take the list first */
+	auto waiters = std::exchange(db_waiters, {});
+
+	for (auto &&[seq, coro]: waiters) {
+		if (seq <= db_durable)
+			coro.resume();
+		else
+			db_waiters.push_back({seq, coro});
+	}
+}
+
+struct commit_waiter {
+	std::uint64_t cw_seq;
+
+	auto await_ready() const noexcept -> bool
+	{
+		return cw_seq <= db_durable;
+	}
+
+	auto await_suspend(std::coroutine_handle<> coro) noexcept -> void
+	try {
+		db_waiters.push_back({cw_seq, coro});
+	} catch (std::bad_alloc const &) {
+		panic("db: out of memory");
+	}
+
+	auto await_resume() const noexcept -> void {}
+};
+
+auto commit() -> task<void>
+{
+	co_await commit_waiter{db_appended};
+}
+
+auto start_recovery() noexcept -> void;
+
+auto flush() noexcept -> std::expected<void, std::error_code>
+{
+	if (db_error)
+		return std::unexpected(db_error);
+
+	if (db_pending.empty())
+		return {};
+
+	auto ret = write_all(db_journal.get(), db_pending);
+	if (ret && ::fsync(db_journal.get()) == -1)
+		ret = std::unexpected(error::from_errno());
 
-	auto serialise_network = [&](auto &hdl) {
+	if (!ret) {
+		/*
+		 * we don't know how much of the write reached the disk, so
+		 * stop writing the journal until a snapshot replaces it.
+		 * commit() callers wait for the snapshot.
+		 */
+		log::error("db: writing journal: {}", ret.error().message());
+		db_error = ret.error();
+		db_pending.clear();
+		start_recovery();
+		return ret;
+	}
+
+	db_stats.st_journal_bytes += db_pending.size();
+	++db_stats.st_syncs;
+	db_pending.clear();
+	db_durable = db_appended;
+	wake_waiters();
+	return {};
+}
+
+/*
+ * write pending records after commit_delay, so that a burst of changes
+ * shares one fsync(), and write a snapshot if the journal has grown too big.
+ */
+auto flusher() -> jtask<void>
+{
+	co_await kq::sleep(commit_delay);
+	db_flush_scheduled = false;
+
+	if (!flush())
+		co_return;
+
+	if (db_stats.st_journal_bytes > compact_size) {
+		if (auto ret = save(); !ret)
+			log::error("db: compaction failed: {}",
+				   ret.error().message());
+	}
+}
+
+/*
+ * the journal failed, so write a snapshot to replace it, retrying until one
+ * is written.  changes are still made meanwhile, and the snapshot includes
+ * them; commit() doesn't return until it's written, so a client is only told
+ * a change succeeded once it's on disk.
+ */
+auto recoverer() -> jtask<void>
+{
+	auto delay = recover_delay;
+
+	for (;;) {
+		auto ret = save();
+		if (ret) {
+			log::info("db: journal replaced by a new snapshot");
+			db_recovering = false;
+			co_return;
+		}
+
+		log::error("db: writing recovery snapshot: {}",
+			   ret.error().message());
+		co_await kq::sleep(delay);
+		delay = std::min(delay * 2, recover_max_delay);
+	}
+}
+
+auto start_recovery() noexcept -> void
+{
+	if (std::exchange(db_recovering, true))
+		return;
+
+	kq::run_task(recoverer());
+}
+
+auto append_record(rectype type, std::span<std::byte const> data) noexcept
+	-> void
+try {
+	/* the snapshot which replaces the failed journal will have this */
+	if (db_error) {
+		++db_appended;
+		return;
+	}
+
+	auto hdr = record_header{
+		.rh_magic = journal_magic,
+		.rh_length = static_cast<std::uint32_t>(data.size()),
+		.rh_crc = 0,
+		.rh_type = type,
+		.rh_pad = {},
+	};
+	hdr.rh_crc = crc32c(data, crc32c(as_bytes(hdr)));
+
+	auto hbytes = as_bytes(hdr);
+	db_pending.insert(db_pending.end(), hbytes.begin(), hbytes.end());
+	db_pending.insert(db_pending.end(), data.begin(), data.end());
+	++db_appended;
+	++db_stats.st_records;
+
+	if (!db_flush_scheduled) {
+		db_flush_scheduled = true;
+		kq::run_task(flusher());
+	}
+} catch (std::bad_alloc const &) {
+	panic("db: out of memory");
+}
+
+auto append_record(rectype type, uuid const &id, std::string_view name) noexcept
+	-> void
+{
+	if (name.size() > proto::cn_maxnetnam)
+		panic("db: network name too long");
+
+	auto payload = std::array<std::byte, sizeof(uuid) + proto::cn_maxnetnam>{};
+	std::memcpy(payload.data(), &id, sizeof(id));
+	std::memcpy(payload.data() + sizeof(id), name.data(), name.size());
+	append_record(type,
+		      std::span(payload).first(sizeof(id) + name.size()));
+}
+
+auto hdl_net_created(network::netinfo info) noexcept -> void
+{
+	if (!db_replaying && db_journal)
+		append_record(rectype::create, info.id, info.name);
+}
+
+auto hdl_net_removed(network::netinfo info) noexcept -> void
+{
+	if (!db_replaying && db_journal)
+		append_record(rectype::remove, info.id, {});
+}
+
+/* a transaction is journalled as a single record */
+auto hdl_txn_applied(std::span<network::netchange const> changes) noexcept
+	-> void
+try {
+	if (db_replaying || !db_journal || changes.empty())
+		return;
+
+	auto payload = std::vector<std::byte>();
+	payload.reserve(changes.size()
+			* (sizeof(txn_entry) + proto::cn_maxnetnam));
+
+	for (auto &&change: changes) {
+		auto create = change.nc_kind == network::txn_op::kind::create;
+		auto name = create ? change.nc_info.name : std::string_view();
+		if (name.size() > proto::cn_maxnetnam)
+			panic("db: network name too long");
+
+		auto entry = txn_entry{
+			.te_type = create ? rectype::create : rectype::remove,
+			.te_namelen = static_cast<std::uint8_t>(name.size()),
+			.te_pad = {},
+			.te_id = change.nc_info.id,
+		};
+
+		auto ebytes = as_bytes(entry);
+		payload.insert(payload.end(), ebytes.begin(), ebytes.end());
+		auto nbytes = std::as_bytes(std::span(name));
+		payload.insert(payload.end(), nbytes.begin(), nbytes.end());
+	}
+
+	append_record(rectype::txn, payload);
+} catch (std::bad_alloc const &) {
+	panic("db: out of memory");
+}
+
+auto save() noexcept -> std::expected<void, std::error_code>
+try {
+	if (!db_dir)
+		return std::unexpected(error::from_errno(EBADF));
+
+	auto nets = std::vector<snapshot_network>();
+
+	for (auto &&hdl: network::findall()) {
 		auto net = info(hdl);
 		if (!net)
 			panic("db::save: network::info: {}",
 			      net.error().message());
-		nvl data;
 
-		data.add_string("name", net->name);
-		return data;
+		auto &snet = nets.emplace_back();
+		snet.sn_id = net->id;
+		snet.sn_namelen = static_cast<std::uint8_t>(net->name.size());
+		std::memcpy(snet.sn_name, net->name.data(), net->name.size());
+	}
+
+	auto entries = std::as_bytes(std::span(nets));
+	auto hdr = snapshot_header{
+		.sh_magic = snapshot_magic,
+		.sh_version = snapshot_version,
+		.sh_count = static_cast<std::uint32_t>(nets.size()),
+		.sh_crc = crc32c(entries),
 	};
 
+	/* write the new snapshot alongside the old one, then replace it */
+	auto sfd = ::openat(db_dir.get(), snapshot_tmpname,
+			    O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	if (sfd == -1)
+		return std::unexpected(error::from_errno());
+	auto snapshot = fd(sfd);
+
+	if (auto ret = write_all(snapshot.get(), as_bytes(hdr)); !ret)
+		return ret;
+	if (auto ret = write_all(snapshot.get(), entries); !ret)
+		return ret;
+	if (::fsync(snapshot.get()) == -1)
+		return std::unexpected(error::from_errno());
+
+	if (::renameat(db_dir.get(), snapshot_tmpname, db_dir.get(),
+		       snapshot_name)
+	    == -1)
+		return std::unexpected(error::from_errno());
+	if (::fsync(db_dir.get()) == -1)
+		return std::unexpected(error::from_errno());
+
+	/*
+	 * the snapshot now has every change, including those not yet written
+	 * to the journal.  if we crash before the journal is emptied, replaying
+	 * it over the snapshot is harmless.
+	 */
+	if (::ftruncate(db_journal.get(), 0) == -1
+	    || ::fsync(db_journal.get()) == -1)
+		return std::unexpected(error::from_errno());
+
+	db_pending.clear();
+	db_durable = db_appended;
+	db_error = {};
+	db_stats.st_journal_bytes = 0;
+	++db_stats.st_snapshots;
+	wake_waiters();
+	return {};
+} catch (std::bad_alloc const &) {
+	panic("db: out of memory");
+}
+
+/*
+ * load the snapshot, if there is one.
+ */
+auto load_snapshot() noexcept -> std::expected<void, std::error_code>
+{
+	auto sfd = ::openat(db_dir.get(), snapshot_name, O_RDONLY | O_CLOEXEC);
+	if (sfd == -1) {
+		if (errno == ENOENT)
+			return {};
+		return std::unexpected(error::from_errno());
+	}
+	auto snapshot = fd(sfd);
+
+	struct stat sb {};
+	if (::fstat(snapshot.get(), &sb) == -1)
+		return std::unexpected(error::from_errno());
+
+	auto size = static_cast<std::size_t>(sb.st_size);
+	if (size < sizeof(snapshot_header))
+		return std::unexpected(error::from_errno(EFTYPE));
+
+	auto *map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE,
+			   snapshot.get(), 0);
+	if (map == MAP_FAILED)
+		return std::unexpected(error::from_errno());
+
+	auto unmap = [&] { ::munmap(map, size); };
+	auto unmap_guard = guard(unmap);
+
+	auto data = std::span(static_cast<std::byte const *>(map), size);
+	auto hdr = snapshot_header{};
+	std::memcpy(&hdr, data.data(), sizeof(hdr));
+	data = data.subspan(sizeof(hdr));
+
+	if (hdr.sh_magic != snapshot_magic
+	    || hdr.sh_version != snapshot_version
+	    || data.size() != hdr.sh_count * sizeof(snapshot_network)
+	    || crc32c(data) != hdr.sh_crc)
+		return std::unexpected(error::from_errno(EFTYPE));
+
+	/* the entries follow a 16-byte header in a page-aligned mapping */
+	auto nets = std::span(
+		reinterpret_cast<snapshot_network const *>(data.data()),
+		hdr.sh_count);
+
+	for (auto &&snet: nets) {
+		if (snet.sn_namelen > proto::cn_maxnetnam)
+			return std::unexpected(error::from_errno(EFTYPE));
+
+		auto name = std::string_view(snet.sn_name, snet.sn_namelen);
+		if (auto ret = network::restore(snet.sn_id, name); !ret)
+			log::warning("db: snapshot: {}: {}", name,
+				     ret.error().message());
+	}
+
+	return {};
+}
+
+/* apply one journal record */
+auto replay(rectype type, std::span<std::byte const> payload) noexcept -> void
+{
+	auto id = uuid{};
+	std::memcpy(&id, payload.data(), sizeof(id));
+
+	switch (type) {
+	case rectype::create: {
+		auto name = std::string_view(
+			reinterpret_cast<char const *>(payload.data())
+				+ sizeof(id),
+			payload.size() - sizeof(id));
+
+		/* the create might already be in the snapshot */
+		(void)network::restore(id, name);
+		break;
+	}
+
+	case rectype::remove:
+		(void)network::remove_byid(id);
+		break;
+
+	case rectype::txn:
+		while (payload.size() >= sizeof(txn_entry)) {
+			auto entry = txn_entry{};
+			std::memcpy(&entry, payload.data(), sizeof(entry));
+			payload = payload.subspan(sizeof(entry));
+
+			if (entry.te_namelen > payload.size())
+				break;
+
+			auto name = std::string_view(
+				reinterpret_cast<char const *>(payload.data()),
+				entry.te_namelen);
+			payload = payload.subspan(entry.te_namelen);
+
+			if (entry.te_type == rectype::create)
+				(void)network::restore(entry.te_id, name);
+			else if (entry.te_type == rectype::remove)
+				(void)network::remove_byid(entry.te_id);
+		}
+		break;
+	}
+}
+
+/*
+ * replay the journal over the snapshot.  replay stops at the first record
+ * which is incomplete or corrupt, which is what a crash during a write
+ * leaves behind, and the journal is truncated there.
+ */
+auto load_journal() noexcept -> std::expected<void, std::error_code>
+try {
+	struct stat sb {};
+	if (::fstat(db_journal.get(), &sb) == -1)
+		return std::unexpected(error::from_errno());
+
+	auto buf = std::vector<std::byte>(static_cast<std::size_t>(sb.st_size));
+	auto nread = ::pread(db_journal.get(), buf.data(), buf.size(), 0);
+	if (nread == -1)
+		return std::unexpected(error::from_errno());
+	buf.resize(static_cast<std::size_t>(nread));
+
+	auto data = std::span<std::byte const>(buf);
+
+	while (data.size() >= sizeof(record_header)) {
+		auto hdr = record_header{};
+		std::memcpy(&hdr, data.data(), sizeof(hdr));
+
+		if (hdr.rh_magic != journal_magic
+		    || hdr.rh_length < sizeof(uuid)
+		    || hdr.rh_length > max_payload
+		    || hdr.rh_length > data.size() - sizeof(hdr))
+			break;
+
+		auto payload = data.subspan(sizeof(hdr), hdr.rh_length);
+		auto crc = std::exchange(hdr.rh_crc, 0);
+		if (crc32c(payload, crc32c(as_bytes(hdr))) != crc)
+			break;
+
+		replay(hdr.rh_type, payload);
+		data = data.subspan(sizeof(hdr) + hdr.rh_length);
+	}
+
+	auto valid = buf.size() - data.size();
+	if (!data.empty()) {
+		log::warning("db: discarding {} bytes at the end of {}",
+			     data.size(), journal_name);
+		if (::ftruncate(db_journal.get(), static_cast<off_t>(valid))
+		    == -1)
+			return std::unexpected(error::from_errno());
+	}
+
+	db_stats.st_journal_bytes = valid;
+	return {};
+} catch (std::bad_alloc const &) {
+	panic("db: out of memory");
+}
+
+auto load() noexcept -> std::expected<void, std::error_code>
+try {
+	if (!db_dir)
+		return std::unexpected(error::from_errno(EBADF));
+
+	/* don't journal the changes we make while loading */
+	db_replaying = true;
+	auto done = [] { db_replaying = false; };
+	auto done_guard = guard(done);
+
+	auto ids = std::vector<uuid>();
 	for (auto &&hdl: network::findall())
-		state.append_nvlist_array("networks", serialise_network(hdl));
+		ids.push_back(network::info(hdl)->id);
+	for (auto &&id: ids)
+		(void)network::remove_byid(id);
+
+	if (auto ret = load_snapshot(); !ret) {
+		log::error("db: loading {}: {}", snapshot_name,
+			   ret.error().message());
+		return ret;
+	}
+
+	if (auto ret = load_journal(); !ret) {
+		log::error("db: loading {}: {}", journal_name,
+			   ret.error().message());
+		return ret;
+	}
 
 	return {};
+} catch (std::bad_alloc const &) {
+	panic("db: out of memory");
+}
+
+/*
+ * the warm-start image.
+ */
+
+auto save_interfaces() noexcept -> std::expected<void, std::error_code>
+try {
+	if (!db_dir)
+		return std::unexpected(error::from_errno(EBADF));
+
+	auto buf = std::vector<std::byte>();
+	auto count = std::uint32_t{0};
+
+	auto append = [&](auto const &obj) {
+		auto bytes = as_bytes(obj);
+		buf.insert(buf.end(), bytes.begin(), bytes.end());
+	};
+
+	iface::visit([&](iface::ifview const &intf) {
+		auto naddrs = std::min(intf.addresses.size(),
+				       std::size_t{UINT8_MAX});
+
+		auto wi = warm_interface{};
+		wi.wi_index = intf.index;
+		wi.wi_flags = intf.flags;
+		wi.wi_operstate = intf.operstate;
+		wi.wi_naddrs = static_cast<std::uint8_t>(naddrs);
+		std::ranges::copy(intf.name.substr(0, sizeof(wi.wi_name)),
+				  wi.wi_name);
+		std::ranges::copy(intf.kind.substr(0, sizeof(wi.wi_kind)),
+				  wi.wi_kind);
+		append(wi);
+
+		for (auto &&addr: intf.addresses.first(naddrs)) {
+			auto wa = warm_address{};
+			wa.wa_family = static_cast<std::uint8_t>(
+				addr.ifa_family);
+			wa.wa_plen = static_cast<std::uint8_t>(addr.ifa_plen);
+			std::visit([&](auto const &a) {
+				std::memcpy(wa.wa_addr, &a, sizeof(a));
+			}, addr.ifa_addr);
+			append(wa);
+		}
+
+		++count;
+	});
+
+	auto hdr = snapshot_header{
+		.sh_magic = warm_magic,
+		.sh_version = warm_version,
+		.sh_count = count,
+		.sh_crc = crc32c(buf),
+	};
+
+	/*
+	 * the image is only a hint, and the checksum catches a torn write, so
+	 * unlike the snapshot this isn't worth an fsync().
+	 */
+	auto wfd = ::openat(db_dir.get(), warm_tmpname,
+			    O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	if (wfd == -1)
+		return std::unexpected(error::from_errno());
+	auto image = fd(wfd);
+
+	if (auto ret = write_all(image.get(), as_bytes(hdr)); !ret)
+		return ret;
+	if (auto ret = write_all(image.get(), buf); !ret)
+		return ret;
+
+	if (::renameat(db_dir.get(), warm_tmpname, db_dir.get(), warm_name)
+	    == -1)
+		return std::unexpected(error::from_errno());
+
+	db_warm_changes = iface::change_count();
+	return {};
+} catch (std::bad_alloc const &) {
+	panic("db: out of memory");
+}
+
+/*
+ * restore the interfaces in the warm-start image, if there is one.
+ */
+auto load_interfaces() noexcept -> std::expected<void, std::error_code>
+try {
+	auto wfd = ::openat(db_dir.get(), warm_name, O_RDONLY | O_CLOEXEC);
+	if (wfd == -1) {
+		if (errno == ENOENT)
+			return {};
+		return std::unexpected(error::from_errno());
+	}
+	auto image = fd(wfd);
+
+	struct stat sb {};
+	if (::fstat(image.get(), &sb) == -1)
+		return std::unexpected(error::from_errno());
+
+	auto buf = std::vector<std::byte>(static_cast<std::size_t>(sb.st_size));
+	auto nread = ::pread(image.get(), buf.data(), buf.size(), 0);
+	if (nread == -1)
+		return std::unexpected(error::from_errno());
+	buf.resize(static_cast<std::size_t>(nread));
+
+	auto data = std::span<std::byte const>(buf);
+	auto hdr = snapshot_header{};
+	if (data.size() < sizeof(hdr))
+		return std::unexpected(error::from_errno(EFTYPE));
+
+	std::memcpy(&hdr, data.data(), sizeof(hdr));
+	data = data.subspan(sizeof(hdr));
+
+	if (hdr.sh_magic != warm_magic || hdr.sh_version != warm_version
+	    || crc32c(data) != hdr.sh_crc)
+		return std::unexpected(error::from_errno(EFTYPE));
+
+	/* parse the whole image before restoring anything */
+	struct entry {
+		warm_interface		   e_intf;
+		std::vector<iface::ifaddr> e_addrs;
+	};
+	auto entries = std::vector<entry>();
+
+	for (auto i = 0u; i < hdr.sh_count; ++i) {
+		auto &ent = entries.emplace_back();
+
+		if (data.size() < sizeof(ent.e_intf))
+			return std::unexpected(error::from_errno(EFTYPE));
+		std::memcpy(&ent.e_intf, data.data(), sizeof(ent.e_intf));
+		data = data.subspan(sizeof(ent.e_intf));
+
+		for (auto j = 0u; j < ent.e_intf.wi_naddrs; ++j) {
+			auto wa = warm_address{};
+			if (data.size() < sizeof(wa))
+				return std::unexpected(
+					error::from_errno(EFTYPE));
+			std::memcpy(&wa, data.data(), sizeof(wa));
+			data = data.subspan(sizeof(wa));
+
+			if (auto addr = iface::make_ifaddr(
+				    wa.wa_family, wa.wa_addr, wa.wa_plen);
+			    addr)
+				ent.e_addrs.push_back(*addr);
+		}
+	}
+
+	if (!data.empty())
+		return std::unexpected(error::from_errno(EFTYPE));
+
+	auto field = [](char const (&str)[IFNAMSIZ]) {
+		return std::string_view(str, ::strnlen(str, IFNAMSIZ));
+	};
+
+	for (auto &&ent: entries)
+		iface::restore(iface::ifview{
+			.name = field(ent.e_intf.wi_name),
+			.kind = field(ent.e_intf.wi_kind),
+			.index = ent.e_intf.wi_index,
+			.operstate = ent.e_intf.wi_operstate,
+			.flags = ent.e_intf.wi_flags,
+			.addresses = ent.e_addrs,
+		});
+
+	log::info("db: restored {} interfaces from {}", entries.size(),
+		  warm_name);
+	return {};
+} catch (std::bad_alloc const &) {
+	panic("db: out of memory");
+}
+
+/*
+ * rewrite the warm-start image every warm_interval, if the interfaces have
+ * changed since it was last written.
+ */
+auto warm_writer() -> jtask<void>
+{
+	for (;;) {
+		co_await kq::sleep(warm_interval);
+
+		if (iface::change_count() == db_warm_changes)
+			continue;
+
+		if (auto ret = save_interfaces(); !ret)
+			log::warning("db: writing {}: {}", warm_name,
+				     ret.error().message());
+	}
+}
+
+/*
+ * the interface database now matches the kernel, so replace the image we
+ * started with.
+ */
+auto hdl_reconciled() noexcept -> void
+{
+	if (auto ret = save_interfaces(); !ret)
+		log::warning("db: writing {}: {}", warm_name,
+			     ret.error().message());
+
+	if (!db_warm_writer) {
+		db_warm_writer = true;
+		kq::run_task(warm_writer());
+	}
+}
+
+auto init(std::string_view path) noexcept
+	-> std::expected<void, std::error_code>
+try {
+	auto spath = std::string(path);
+
+	if (::mkdir(spath.c_str(), 0700) == -1 && errno != EEXIST)
+		return std::unexpected(error::from_errno());
+
+	auto dfd = ::open(spath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (dfd == -1)
+		return std::unexpected(error::from_errno());
+	db_dir = fd(dfd);
+
+	auto jfd = ::openat(dfd, journal_name,
+			    O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+	if (jfd == -1)
+		return std::unexpected(error::from_errno());
+	db_journal = fd(jfd);
+
+	db_pending.clear();
+	db_durable = db_appended;
+	db_error = {};
+
+	net_created_sub = event::sub(network::net_created, hdl_net_created);
+	net_removed_sub = event::sub(network::net_removed, hdl_net_removed);
+	txn_applied_sub = event::sub(network::txn_applied, hdl_txn_applied);
+	reconciled_sub = event::sub(iface::reconciled, hdl_reconciled);
+
+	if (auto ret = load(); !ret)
+		return ret;
+
+	/* the image is only a hint, so carry on without it */
+	if (auto ret = load_interfaces(); !ret)
+		log::warning("db: loading {}: {}", warm_name,
+			     ret.error().message());
+
+	return {};
+} catch (std::bad_alloc const &) {
+	panic("db: out of memory");
+}
+
+auto get_stats() noexcept -> stats
+{
+	return db_stats;
 }
 
 } // namespace netd::db
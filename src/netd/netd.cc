@@ -24,25 +24,37 @@
 #include <sys/event.h>
 
 #include <cerrno>
+#include <charconv>
+#include <chrono>
 #include <coroutine>
 #include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <optional>
 #include <print>
+#include <string_view>
+#include <system_error>
+
+#include <unistd.h>
 
 import netd.network;
 import ctl;
+import db;
 import log;
+import neigh;
 import iface;
 import netlink;
+import route;
+import shm;
 import netd.util;
 import netd.async;
 
 namespace netd {
 
-auto start() -> jtask<void>
+auto start(std::chrono::steady_clock::time_point started, ctl::limits limits)
+	-> jtask<void>
 {
 	// TODO: remove use of std::exit here
 
@@ -55,17 +67,52 @@ auto start() -> jtask<void>
 		std::exit(1); // NOLINT
 	}
 
-	if (auto ret = co_await netlink::init(); !ret) {
-		log::fatal("netlink init failed: {}", ret.error().message());
+	/* likewise for the routing and neighbour tables */
+	route::init();
+	neigh::init();
+
+	/* the stats segment is optional, so don't fail if we can't create it */
+	if (auto ret = shm::init(); !ret)
+		log::warning("shm init failed: {}", ret.error().message());
+
+	/*
+	 * the database also restores the interfaces we knew about last time,
+	 * so ctl can answer queries (marked stale) while netlink is still
+	 * fetching the real ones from the kernel.
+	 */
+	if (auto ret = db::init(); !ret) {
+		log::fatal("db init failed: {}", ret.error().message());
 		std::exit(1); // NOLINT
 	}
 
-	if (auto ret = ctl::init(); !ret) {
+	if (auto ret = ctl::init(started, limits); !ret) {
 		log::fatal("ctl init failed: {}", ret.error().message());
 		std::exit(1); // NOLINT
 	}
 
-	log::info("startup complete");
+	if (auto ret = co_await netlink::init(); !ret) {
+		log::fatal("netlink init failed: {}", ret.error().message());
+		std::exit(1); // NOLINT
+	}
+
+	log::info("startup complete; consistent after {}",
+		  std::chrono::duration_cast<std::chrono::milliseconds>(
+			  std::chrono::steady_clock::now() - started));
+}
+
+/*
+ * parse a timeout given in seconds on the command line.
+ */
+auto parse_timeout(std::string_view arg) -> std::optional<std::chrono::seconds>
+{
+	auto secs = unsigned{};
+	auto end = arg.data() + arg.size();
+	auto ret = std::from_chars(arg.data(), end, secs);
+
+	if (ret.ec != std::errc() || ret.ptr != end || secs == 0)
+		return {};
+
+	return std::chrono::seconds(secs);
 }
 
 } // namespace netd
@@ -74,11 +121,40 @@ int main(int argc, char **argv)
 {
 	using namespace netd;
 
-	if (argc != 1) {
-		std::print(stderr, "usage: {}\n", argv[0]);
+	auto started = std::chrono::steady_clock::now();
+	auto limits = ctl::limits();
+	auto usage = [&] {
+		std::print(stderr, "usage: {} [-d] [-i idle] [-r request]\n",
+			   argv[0]);
 		return 1;
+	};
+
+	int ch;
+	while ((ch = getopt(argc, argv, "di:r:")) != -1) {
+		switch (ch) {
+		case 'd':
+			log::set_level(log::severity::debug);
+			break;
+		case 'i':
+		case 'r': {
+			auto timeout = parse_timeout(optarg);
+			if (!timeout)
+				return usage();
+
+			if (ch == 'i')
+				limits.cl_idle = *timeout;
+			else
+				limits.cl_request = *timeout;
+			break;
+		}
+		default:
+			return usage();
+		}
 	}
 
+	if (optind != argc)
+		return usage();
+
 	log::info("starting");
 
 	if (auto ret = kq::init(); !ret) {
@@ -86,7 +162,10 @@ int main(int argc, char **argv)
 		return 1;
 	}
 
-	kq::run_task(netd::start());
+	/* from now on, log messages are written out by the event loop */
+	log::start_async();
+
+	kq::run_task(netd::start(started, limits));
 
 	if (auto ret = kq::run(); !ret) {
 		log::fatal("kqrun: {}", ret.error().message());